@@ -0,0 +1,120 @@
+#ifndef LEVENSHTEIN_H_
+#define LEVENSHTEIN_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Edit distances between token hash sequences
+
+// Myers' bit parallel edit distance (J. ACM 46(3), 1999) in blocks of
+// 64 tokens of the shorter sequence - a column of the DP matrix is a
+// few words of vertical deltas, updated for every token of the other.
+inline int levenshtein_distance(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+{
+    const std::vector<uint64_t>& p = a.size() <= b.size() ? a : b;
+    const std::vector<uint64_t>& t = a.size() <= b.size() ? b : a;
+    size_t m = p.size();
+    if (!m)
+        return t.size();
+
+    // every distinct token of p gets a row of match bits
+    size_t blocks = (m + 63) / 64;
+    std::unordered_map<uint64_t, size_t> symbols;
+    std::vector<uint64_t> peq;
+    for (size_t i = 0; i < m; ++i) {
+        auto it = symbols.emplace(p[i], symbols.size()).first;
+        if (peq.size() < symbols.size() * blocks)
+            peq.resize(symbols.size() * blocks);
+        peq[it->second * blocks + i / 64] |= uint64_t(1) << (i % 64);
+    }
+    // tokens of t not in p match nowhere - an extra all zero row
+    size_t nomatch = symbols.size();
+    peq.resize(peq.size() + blocks);
+
+    std::vector<uint64_t> pv(blocks, ~uint64_t(0));
+    std::vector<uint64_t> mv(blocks, 0);
+    uint64_t last = uint64_t(1) << ((m - 1) % 64);
+    int score = m;
+    for (uint64_t x : t) {
+        auto it = symbols.find(x);
+        const uint64_t* eqs = &peq[(it == symbols.end() ? nomatch : it->second) * blocks];
+        // the top row grows by one per token
+        int hin = 1;
+        for (size_t k = 0; k < blocks; ++k) {
+            uint64_t eq = eqs[k];
+            uint64_t xv = eq | mv[k];
+            if (hin < 0)
+                eq |= 1;
+            uint64_t xh = (((eq & pv[k]) + pv[k]) ^ pv[k]) | eq;
+            uint64_t ph = mv[k] | ~(xh | pv[k]);
+            uint64_t mh = pv[k] & xh;
+            uint64_t high = k == blocks - 1 ? last : uint64_t(1) << 63;
+            int hout = (ph & high) ? 1 : (mh & high) ? -1 : 0;
+            ph <<= 1;
+            mh <<= 1;
+            if (hin < 0)
+                mh |= 1;
+            else if (hin > 0)
+                ph |= 1;
+            pv[k] = mh | ~(xv | ph);
+            mv[k] = ph & xv;
+            hin = hout;
+        }
+        score += hin;
+    }
+    return score;
+}
+
+// The edit distance if it's at most k, -1 otherwise. Only the diagonal
+// band of width 2k + 1 can hold distances <= k, and once a whole row of
+// the band is above k, the result is too.
+inline int levenshtein_within(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, int k)
+{
+    if (k < 0)
+        return -1;
+    const std::vector<uint64_t>& s = a.size() <= b.size() ? a : b;
+    const std::vector<uint64_t>& t = a.size() <= b.size() ? b : a;
+    int n = s.size();
+    int m = t.size();
+    if (m - n > k)
+        return -1;
+    // a cell of the band costs about half of what a 64 bit block step
+    // costs - for wide bands the full bit parallel run is cheaper
+    if (int64_t(n) * (2 * k + 1) > 2 * int64_t(m) * ((n + 63) / 64)) {
+        int d = levenshtein_distance(s, t);
+        return d > k ? -1 : d;
+    }
+
+    // a row of the DP matrix, cells outside the band stay above k
+    const int over = k + 1;
+    std::vector<int> v0(m + 1, over), v1(m + 1, over);
+    for (int j = 0; j <= std::min(m, k); j++)
+        v0[j] = j;
+    for (int i = 0; i < n; i++) {
+        int from = std::max(0, i + 1 - k);
+        int to = std::min(m, i + 1 + k);
+        int best = over;
+        v1[from ? from - 1 : 0] = over;
+        if (!from) {
+            v1[0] = i + 1;
+            best = v1[0];
+            from = 1;
+        }
+        for (int j = from; j <= to; j++) {
+            int cost = (s[i] == t[j - 1]) ? 0 : 1;
+            int d = std::min(std::min(v1[j - 1] + 1, v0[j] + 1), v0[j - 1] + cost);
+            v1[j] = std::min(d, over);
+            best = std::min(best, v1[j]);
+        }
+        if (to < m)
+            v1[to + 1] = over;
+        if (best > k)
+            return -1;
+        v0.swap(v1);
+    }
+    return v0[m] > k ? -1 : v0[m];
+}
+
+#endif
@@ -1,48 +1,85 @@
+#include <atomic>
 #include <cstdint>
-#include <list>
 #include <vector>
 #include <string>
 #include <set>
+#include <thread>
 
 struct Match {
-    int start;
+    size_t start;
     int matched;
     int pattern;
     int sline;
     int eline;
 };
 
-typedef std::list<Match> Matches;
+typedef std::vector<Match> Matches;
 
+// what matching needs of a token - 16 bytes and no allocation
 struct Token {
     int linenumber;
     uint64_t hash;
-    std::string text;
 };
 
 typedef std::vector<Token> TokenList;
+// the (lower cased) text of the tokens, only collected on request
+typedef std::vector<std::string> TokenTexts;
 
-class TokenTree;
+class PatternTree;
+
+enum MatchEngine {
+    // restart the walk through the pattern tree at every token
+    ENGINE_TRIE,
+    // walk the text once, following failure links
+    ENGINE_AHO_CORASICK
+};
 
 struct Matcher {
-    std::set<uint64_t> ignored_tokens;
-    TokenTree *pattern_tree;
+    PatternTree *pattern_tree;
+    // Patterns added after a dump was loaded are kept in a tree of
+    // their own and scanned next to the dump instead of copying it, the
+    // patterns removed from the dump are only left out of its matches.
+    // A dump of the matcher merges them
+    PatternTree *overlay;
+    std::set<uint32_t> removed;
 
-    ssize_t longest_pattern;
+    // writes a dump in the background - everything modifying the
+    // matcher waits for it first
+    std::thread compaction;
+    bool compaction_ok;
 
-    static Matcher* _self;
-    static Matcher* self() {
-      if (!_self) {
-        _self = new Matcher();
-      }
+    // tokens in the longest pattern
+    ssize_t longest_pattern;
+    // text tokens the longest match can span ($SKIPn counting n)
+    ssize_t longest_reach;
 
-      return _self;
-    }
+    // $SKIP sub-walks done and saved over all scans, the scans only
+    // read the matcher otherwise
+    mutable std::atomic<uint64_t> skip_walks;
+    mutable std::atomic<uint64_t> skip_pruned;
 
     Matcher();
-    bool to_ignore(uint64_t t) const;
-    bool to_ignore(const char *t, unsigned int len) const;
+    ~Matcher();
     void init();
-    void add_token(TokenList& result, const char* start, size_t len, int line) const;
-    void tokenize(TokenList& result, char* str, int linenumber = 0);
+    // returns if the last compaction was written
+    bool wait_compaction();
+
+    // bump whenever tokenize gives other tokens for any text - the dumps
+    // cached by load_or_build are compiled by a certain version
+    static const int TOKENIZER_VERSION = 1;
+
+    // the tokenizer does not depend on the patterns, so it's usable
+    // without a Matcher instance
+    static bool to_ignore(uint64_t t);
+    static bool to_ignore(const char *t, unsigned int len);
+    static void add_token(TokenList& result, const char* start, size_t len, int line, TokenTexts* texts);
+    // tokenize len bytes of str, the text is not modified. A linenumber
+    // of 0 is for patterns, otherwise every newline advances it and the
+    // line the text ends on is returned. If texts is given, the text of
+    // every token is added to it as well
+    static int tokenize(TokenList& result, const char* str, size_t len, int linenumber = 0, TokenTexts* texts = 0);
+
+private:
+    // forbidden
+    Matcher(const Matcher&);
 };
@@ -0,0 +1,37 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Run f(0) .. f(count - 1) on up to `threads` native threads. The
+// indexes are handed out one by one, so uneven work (e.g. files of very
+// different size) is balanced between the workers. f must not touch any
+// perl data structures - it runs outside of the interpreter.
+template <typename F>
+void parallel_for(size_t count, unsigned int threads, F f)
+{
+    if (threads > count)
+        threads = count;
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            f(i);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            size_t i;
+            while ((i = next++) < count)
+                f(i);
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+}
+
+#endif
@@ -3,34 +3,44 @@
 
 /* This is based on AATree of the C++ data structure book */
 
-#include <forward_list>
-#include <iostream> // For NULL
-#include <map>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <set>
 #include <string>
+#include <sys/mman.h>
+#include <vector>
 
-// TokenTree class
+// All TokenTrees of one Matcher live in flat arrays and link to each
+// other by index only. That way a dump is just these arrays and can be
+// used in place from a mapped file - by as many processes as we like.
+// Index 0 is a null entry in every array.
 //
-// CONSTRUCTION: with ITEM_NOT_FOUND object used to signal failed finds
+// While patterns are added, the token edges of every tree are kept in
+// an AA tree. Before matching, freeze() flattens them into one sorted
+// run of Edges per tree, which is what find() searches and what is
+// dumped - the AA nodes are only rebuilt if a loaded dump is modified.
+//
+// merge() builds the union of a tree and one with patterns added later
+// right into the frozen arrays, that's how the patterns added on top of
+// a loaded dump are compacted into a new one.
 //
 // ******************PUBLIC OPERATIONS*********************
-// void insert( x )       --> Insert x
-// uint64_t find( x )   --> Return item that matches x
-
-// Node and forward declaration because g++ does
-// not understand nested classes.
-class TokenTree;
-
-class AANode;
+// TokenTree* find( t, x )          --> Return the tree following x in t
+// uint32_t insert( t, x )          --> Find or create the tree following x
+// uint32_t insert_skip( t, skip )  --> Same for a $SKIP edge
+// void freeze( )                   --> Build the edges for find
+// void link( )                     --> Build the Aho-Corasick links
+// void merge( base, overlay, ... ) --> Become the union of two trees
 
 struct AANode {
-
     uint64_t element;
-    TokenTree* next_token;
+    uint32_t next_token; // index into trees
     uint32_t left;
     uint32_t right;
     uint16_t level;
 
-    AANode(const uint64_t& e, TokenTree* nt, int lt, int rt, int lv = 1)
+    AANode(uint64_t e, uint32_t nt, uint32_t lt, uint32_t rt, uint16_t lv = 1)
         : element(e)
         , next_token(nt)
         , left(lt)
@@ -38,122 +48,338 @@ struct AANode {
         , level(lv)
     {
     }
-
-    friend class TokenTree;
-
-private:
-    AANode()
-    {
-    }
 };
 
-typedef std::forward_list<std::pair<unsigned char, TokenTree*> > SkipList;
-
-struct SerializeInfo {
-    std::map<const TokenTree*, int> trees;
-    int32_t tree_count;
-    std::map<uint64_t, int> elements;
-    int32_t element_count;
+struct Edge {
+    uint64_t element;
+    uint32_t next_token; // index into trees
+    uint32_t padding;
+};
 
-    SerializeInfo()
+// single linked list of the $SKIP edges of a tree - sorted by skip
+struct SkipNode {
+    uint32_t tree; // index into trees
+    uint32_t next; // index into skips
+    uint8_t skip;
+    uint8_t padding[3];
+
+    SkipNode(uint8_t s, uint32_t t, uint32_t n)
+        : tree(t)
+        , next(n)
+        , skip(s)
     {
-        tree_count = element_count = 0;
+        memset(padding, 0, sizeof(padding));
     }
 };
 
-class TokenTree {
-public:
-    TokenTree();
-    ~TokenTree();
-
-    TokenTree* find(uint64_t x) const;
-    void mark_elements(SerializeInfo& si) const;
-
-    void insert(uint64_t x, TokenTree* next_token);
+// everything find_matches needs of one state within one cache line
+struct TokenTree {
+    uint32_t pid;
+    uint32_t skips; // index into skips
+    uint32_t edges; // index into edges
+    uint32_t edge_count;
+};
 
-    const TokenTree& operator=(const TokenTree& rhs);
-    void printTree() const;
+// Aho-Corasick links of a state reachable from the root by token edges
+// only - the $SKIP subtrees are walked the classic way.
+struct FailureLink {
+    uint32_t fail; // longest proper suffix that is a state too
+    uint32_t output; // next state on the fail chain that has a pid or skips
+    uint32_t depth; // tokens from the root
+};
 
-    uint32_t pid;
-    SkipList* skips;
-    uint32_t root;
+// the dump format depends on these
+static_assert(sizeof(Edge) == 16, "Edge layout");
+static_assert(sizeof(SkipNode) == 12, "SkipNode layout");
+static_assert(sizeof(TokenTree) == 16, "TokenTree layout");
 
-    static std::vector<AANode> nodes;
+class PatternTree {
+public:
+    static const uint32_t ROOT = 1;
+
+    PatternTree();
+    ~PatternTree();
+
+    // the arrays are either our own vectors or point into a mapped dump
+    const TokenTree* trees;
+    const SkipNode* skips;
+    const Edge* edges;
+    uint32_t tree_count;
+    uint32_t skip_count;
+    uint32_t edge_count;
+
+    const TokenTree* root() const { return trees + ROOT; }
+    // only valid when frozen
+    const TokenTree* find(const TokenTree* t, uint64_t x) const;
+
+    uint32_t insert(uint32_t tree, uint64_t x);
+    uint32_t insert_skip(uint32_t tree, unsigned char skip);
+    // returns the previous pid
+    uint32_t set_pid(uint32_t tree, uint32_t pid);
+    bool has_pid(uint32_t pid) const;
+    // returns false if no state had the pid
+    bool clear_pid(uint32_t pid);
+
+    void freeze();
+    bool is_frozen() const { return frozen; }
+
+    // computed on demand, not part of the dump
+    void link();
+    bool is_linked() const { return !links.empty(); }
+    const FailureLink& link_of(const TokenTree* t) const { return links[t - trees]; }
+
+    // take over a mapping of a dump, the arrays point into it
+    void use_mapping(void* addr, size_t length,
+        const TokenTree* t, uint32_t tc,
+        const SkipNode* s, uint32_t sc,
+        const Edge* e, uint32_t ec);
+    bool is_mapped() const { return mapping != 0; }
+
+    // become the union of the frozen trees base and overlay (which may
+    // be null), leaving out the pids of base in removed. The pids of
+    // overlay win and states leading to no pid are dropped
+    void merge(const PatternTree& base, const PatternTree* overlay, const std::set<uint32_t>& removed);
+
+    void printTree(uint32_t tree) const;
 
-    void initNull()
-    {
-        if (nodes.empty())
-            nodes.emplace_back(0, (TokenTree*)0, 0, 0, 0);
-        root = 0;
-    }
+private:
+    std::vector<TokenTree> own_trees;
+    std::vector<SkipNode> own_skips;
+    std::vector<Edge> own_edges;
+    // the AA trees, only while building
+    std::vector<AANode> nodes;
+    std::vector<uint32_t> roots;
+    // false if the AA trees have to be rebuilt from the edges first
+    bool editable;
+    bool frozen;
+    std::vector<FailureLink> links;
+
+    void* mapping;
+    size_t mapping_length;
+
+    uint32_t new_tree();
+    void unshare();
+    void sync();
+    uint32_t find_node(uint32_t tree, uint64_t x) const;
 
     // Recursive routines
-    int insert(uint64_t x, TokenTree* next_token, int t);
-    void printTree(int t, const std::string&) const;
-    void mark_elements(int t, SerializeInfo& si) const;
+    uint32_t insert(uint64_t x, uint32_t next_token, uint32_t t);
+    void printTree(uint32_t t, const std::string&) const;
 
     // Rotations
-    int skew(int t);
-    int split(int t);
+    uint32_t skew(uint32_t t);
+    uint32_t split(uint32_t t);
 
     // forbidden
-    TokenTree(const TokenTree& rhs);
+    PatternTree(const PatternTree& rhs);
+    const PatternTree& operator=(const PatternTree& rhs);
 };
 
 /**
- * Construct the tree.
+ * Construct the null entries and an empty root.
  */
-TokenTree::TokenTree()
+PatternTree::PatternTree()
 {
-    initNull();
-    pid = 0;
-    skips = 0;
+    mapping = 0;
+    mapping_length = 0;
+    nodes.emplace_back(0, 0, 0, 0, 0);
+    own_skips.emplace_back(0, 0, 0);
+    own_edges.push_back(Edge { 0, 0, 0 });
+    new_tree(); // null
+    new_tree(); // ROOT
+    editable = true;
+    frozen = false;
+    freeze();
 }
 
-/* 
- * Destructor for the tree.
- */
-TokenTree::~TokenTree()
+PatternTree::~PatternTree()
 {
-    delete skips;
+    if (mapping)
+        munmap(mapping, mapping_length);
 }
 
-/*
- * Insert x into the tree; duplicates are ignored.
+void PatternTree::sync()
+{
+    // every modification goes through here
+    links.clear();
+    trees = own_trees.data();
+    tree_count = own_trees.size();
+    skips = own_skips.data();
+    skip_count = own_skips.size();
+    edges = own_edges.data();
+    edge_count = own_edges.size();
+}
+
+template <typename T>
+static void release(std::vector<T>& v)
+{
+    std::vector<T>().swap(v);
+}
+
+void PatternTree::use_mapping(void* addr, size_t length,
+    const TokenTree* t, uint32_t tc,
+    const SkipNode* s, uint32_t sc,
+    const Edge* e, uint32_t ec)
+{
+    if (mapping)
+        munmap(mapping, mapping_length);
+    mapping = addr;
+    mapping_length = length;
+    release(own_trees);
+    release(own_skips);
+    release(own_edges);
+    release(nodes);
+    release(roots);
+    release(links);
+    trees = t;
+    tree_count = tc;
+    skips = s;
+    skip_count = sc;
+    edges = e;
+    edge_count = ec;
+    editable = false;
+    frozen = true;
+}
+
+/**
+ * Copy a mapped dump into our own memory before modifying it - the
+ * AA trees are not part of the dump, so they are rebuilt from the edges.
  */
-void TokenTree::insert(uint64_t x, TokenTree* next_token)
+void PatternTree::unshare()
 {
-    root = insert(x, next_token, root);
+    if (mapping) {
+        own_trees.assign(trees, trees + tree_count);
+        own_skips.assign(skips, skips + skip_count);
+        own_edges.assign(edges, edges + edge_count);
+        munmap(mapping, mapping_length);
+        mapping = 0;
+        mapping_length = 0;
+    }
+    if (editable)
+        return;
+
+    nodes.clear();
+    nodes.reserve(own_edges.size());
+    nodes.emplace_back(0, 0, 0, 0, 0);
+    roots.assign(own_trees.size(), 0);
+    for (uint32_t t = 0; t < own_trees.size(); ++t) {
+        const TokenTree& tree = own_trees[t];
+        for (uint32_t e = tree.edges; e < tree.edges + tree.edge_count; ++e)
+            roots[t] = insert(own_edges[e].element, own_edges[e].next_token, roots[t]);
+    }
+    editable = true;
+    sync();
 }
 
-void TokenTree::printTree() const
+/**
+ * Flatten the AA trees into the sorted edges used by find.
+ */
+void PatternTree::freeze()
 {
-    if (root == 0)
-        std::cerr << "Empty tree" << std::endl;
-    else
-        printTree(root, "");
+    if (frozen)
+        return;
+
+    own_edges.resize(1);
+    own_edges.reserve(nodes.size());
+
+    // in-order walk, iterative as the AA trees are only log(n) deep anyway
+    std::vector<uint32_t> stack;
+    for (uint32_t t = 0; t < own_trees.size(); ++t) {
+        own_trees[t].edges = own_edges.size();
+        uint32_t current = roots[t];
+        while (current || !stack.empty()) {
+            while (current) {
+                stack.push_back(current);
+                current = nodes[current].left;
+            }
+            current = stack.back();
+            stack.pop_back();
+            own_edges.push_back(Edge { nodes[current].element, nodes[current].next_token, 0 });
+            current = nodes[current].right;
+        }
+        own_trees[t].edge_count = own_edges.size() - own_trees[t].edges;
+    }
+    frozen = true;
+    sync();
 }
 
-void TokenTree::printTree(int t, const std::string& indent) const
+/**
+ * Compute the failure links of the states below the root (breadth
+ * first, so the links of shorter prefixes are known when needed).
+ */
+void PatternTree::link()
 {
-    if (t == 0)
+    if (is_linked())
         return;
-    std::string ni = indent + "  ";
-    printTree(nodes[t].left, ni);
-    fprintf(stderr, "%s(%d-%d-%d) %lu\n", indent.c_str(), nodes[t].left, t, nodes[t].right, nodes[t].element);
-    printTree(nodes[t].right, ni);
+    freeze();
+
+    links.assign(tree_count, FailureLink { 0, 0, 0 });
+    links[ROOT].fail = ROOT;
+
+    std::vector<uint32_t> queue(1, ROOT);
+    for (size_t q = 0; q < queue.size(); ++q) {
+        uint32_t s = queue[q];
+        const TokenTree& st = trees[s];
+        for (uint32_t e = st.edges; e < st.edges + st.edge_count; ++e) {
+            uint64_t x = edges[e].element;
+            uint32_t t = edges[e].next_token;
+            uint32_t fail = ROOT;
+            if (s != ROOT) {
+                const TokenTree* f = trees + links[s].fail;
+                const TokenTree* next;
+                while (!(next = find(f, x)) && f != root())
+                    f = trees + links[f - trees].fail;
+                if (next)
+                    fail = next - trees;
+            }
+            const TokenTree& ft = trees[fail];
+            links[t].fail = fail;
+            links[t].depth = links[s].depth + 1;
+            if (fail != ROOT && (ft.pid || ft.skips))
+                links[t].output = fail;
+            else
+                links[t].output = links[fail].output;
+            queue.push_back(t);
+        }
+    }
+}
+
+uint32_t PatternTree::new_tree()
+{
+    own_trees.push_back(TokenTree { 0, 0, 0, 0 });
+    roots.push_back(0);
+    return own_trees.size() - 1;
 }
 
 /**
  * Find item x in the tree.
  * Return the next token tree or NULL
  */
-TokenTree* TokenTree::find(uint64_t x) const
+inline const TokenTree* PatternTree::find(const TokenTree* t, uint64_t x) const
+{
+    const Edge* base = edges + t->edges;
+    uint32_t len = t->edge_count;
+    if (!len)
+        return 0;
+    // branchless binary search - the compiler turns the ternary into a
+    // conditional move, so only the loads remain
+    while (len > 1) {
+        uint32_t half = len / 2;
+        base = (base[half].element <= x) ? base + half : base;
+        len -= half;
+    }
+    return base->element == x ? trees + base->next_token : 0;
+}
+
+/**
+ * Find item x in the AA tree of tree.
+ * Return the index of the next token tree or 0
+ */
+uint32_t PatternTree::find_node(uint32_t tree, uint64_t x) const
 {
-    int current = root;
-    nodes[0].element = x;
+    uint32_t current = roots[tree];
 
-    for (;;) {
+    while (current) {
         const AANode& cn = nodes[current];
         if (x < cn.element) {
             current = cn.left;
@@ -162,6 +388,269 @@ TokenTree* TokenTree::find(uint64_t x) const
         } else
             return cn.next_token;
     }
+    return 0;
+}
+
+/*
+ * Return the tree following x in tree - created if needed.
+ */
+uint32_t PatternTree::insert(uint32_t tree, uint64_t x)
+{
+    // a mapped dump has no AA trees, but is always frozen
+    if (!editable) {
+        const TokenTree* next = find(trees + tree, x);
+        if (next)
+            return next - trees;
+    } else {
+        uint32_t next = find_node(tree, x);
+        if (next)
+            return next;
+    }
+
+    unshare();
+    uint32_t nt = new_tree();
+    roots[tree] = insert(x, nt, roots[tree]);
+    frozen = false;
+    sync();
+    return nt;
+}
+
+/*
+ * Return the tree following a $SKIP edge - created if needed.
+ */
+uint32_t PatternTree::insert_skip(uint32_t tree, unsigned char skip)
+{
+    uint32_t last = 0;
+    for (uint32_t s = trees[tree].skips; s; s = skips[s].next) {
+        if (skips[s].skip == skip)
+            return skips[s].tree;
+        if (skips[s].skip > skip)
+            break;
+        last = s;
+    }
+
+    unshare();
+    uint32_t nt = new_tree();
+    uint32_t next = last ? own_skips[last].next : own_trees[tree].skips;
+    own_skips.emplace_back(skip, nt, next);
+    uint32_t index = own_skips.size() - 1;
+    if (last)
+        own_skips[last].next = index;
+    else
+        own_trees[tree].skips = index;
+    sync();
+    return nt;
+}
+
+uint32_t PatternTree::set_pid(uint32_t tree, uint32_t pid)
+{
+    uint32_t old = trees[tree].pid;
+    if (old != pid) {
+        unshare();
+        own_trees[tree].pid = pid;
+        links.clear();
+    }
+    return old;
+}
+
+bool PatternTree::has_pid(uint32_t pid) const
+{
+    for (uint32_t t = ROOT; t < tree_count; ++t)
+        if (trees[t].pid == pid)
+            return true;
+    return false;
+}
+
+bool PatternTree::clear_pid(uint32_t pid)
+{
+    bool found = false;
+    for (uint32_t t = ROOT; t < tree_count; ++t) {
+        if (trees[t].pid == pid) {
+            set_pid(t, 0);
+            found = true;
+        }
+    }
+    return found;
+}
+
+/**
+ * Walk base and overlay side by side (with a stack, patterns can be
+ * thousands of tokens deep) and create a state for every pair of states
+ * reached by the same tokens and $SKIP edges. As all edges of a state
+ * are created at once, they end up next to each other just like freeze
+ * puts them. Patterns removed leave states behind that lead nowhere,
+ * so a second pass copies only the states leading to a pid - children
+ * are created after their parents, so one backwards loop finds them.
+ */
+void PatternTree::merge(const PatternTree& base, const PatternTree* overlay, const std::set<uint32_t>& removed)
+{
+    struct Pair {
+        uint32_t tree;
+        uint32_t base; // 0 if only in overlay
+        uint32_t overlay; // 0 if only in base
+    };
+
+    // at most everything of both, so the arrays never grow by copying
+    std::vector<TokenTree> all_trees(ROOT + 1, TokenTree { 0, 0, 0, 0 });
+    all_trees.reserve(base.tree_count + (overlay ? overlay->tree_count : 0));
+    std::vector<SkipNode> all_skips(1, SkipNode(0, 0, 0));
+    all_skips.reserve(base.skip_count + (overlay ? overlay->skip_count : 0));
+    std::vector<Edge> all_edges(1, Edge { 0, 0, 0 });
+    all_edges.reserve(base.edge_count + (overlay ? overlay->edge_count : 0));
+    std::vector<Pair> stack(1, Pair { ROOT, ROOT, overlay ? ROOT : 0 });
+    while (!stack.empty()) {
+        Pair p = stack.back();
+        stack.pop_back();
+        const TokenTree* bt = p.base ? base.trees + p.base : 0;
+        const TokenTree* ot = p.overlay ? overlay->trees + p.overlay : 0;
+
+        uint32_t pid = ot ? ot->pid : 0;
+        if (!pid && bt && bt->pid && !removed.count(bt->pid))
+            pid = bt->pid;
+        all_trees[p.tree].pid = pid;
+
+        const Edge* be = bt ? base.edges + bt->edges : 0;
+        const Edge* bend = bt ? be + bt->edge_count : 0;
+        const Edge* oe = ot ? overlay->edges + ot->edges : 0;
+        const Edge* oend = ot ? oe + ot->edge_count : 0;
+        all_trees[p.tree].edges = all_edges.size();
+        while (be != bend || oe != oend) {
+            Pair next = { uint32_t(all_trees.size()), 0, 0 };
+            uint64_t x;
+            if (oe == oend || (be != bend && be->element < oe->element)) {
+                x = be->element;
+                next.base = (be++)->next_token;
+            } else if (be == bend || oe->element < be->element) {
+                x = oe->element;
+                next.overlay = (oe++)->next_token;
+            } else {
+                x = be->element;
+                next.base = (be++)->next_token;
+                next.overlay = (oe++)->next_token;
+            }
+            all_trees.push_back(TokenTree { 0, 0, 0, 0 });
+            all_edges.push_back(Edge { x, next.tree, 0 });
+            stack.push_back(next);
+        }
+        all_trees[p.tree].edge_count = all_edges.size() - all_trees[p.tree].edges;
+
+        // both lists are sorted by skip, so is the merged one
+        uint32_t bs = bt ? bt->skips : 0;
+        uint32_t os = ot ? ot->skips : 0;
+        uint32_t last = 0;
+        while (bs || os) {
+            Pair next = { uint32_t(all_trees.size()), 0, 0 };
+            uint8_t skip;
+            if (!os || (bs && base.skips[bs].skip < overlay->skips[os].skip)) {
+                skip = base.skips[bs].skip;
+                next.base = base.skips[bs].tree;
+                bs = base.skips[bs].next;
+            } else if (!bs || overlay->skips[os].skip < base.skips[bs].skip) {
+                skip = overlay->skips[os].skip;
+                next.overlay = overlay->skips[os].tree;
+                os = overlay->skips[os].next;
+            } else {
+                skip = base.skips[bs].skip;
+                next.base = base.skips[bs].tree;
+                next.overlay = overlay->skips[os].tree;
+                bs = base.skips[bs].next;
+                os = overlay->skips[os].next;
+            }
+            all_trees.push_back(TokenTree { 0, 0, 0, 0 });
+            all_skips.emplace_back(skip, next.tree, 0);
+            uint32_t index = all_skips.size() - 1;
+            if (last)
+                all_skips[last].next = index;
+            else
+                all_trees[p.tree].skips = index;
+            last = index;
+            stack.push_back(next);
+        }
+    }
+
+    // the new index of every state leading to a pid, 0 for the others
+    std::vector<uint32_t> renumber(all_trees.size(), 0);
+    for (uint32_t t = all_trees.size() - 1; t > ROOT; --t) {
+        const TokenTree& tree = all_trees[t];
+        bool live = tree.pid != 0;
+        for (uint32_t e = tree.edges; !live && e < tree.edges + tree.edge_count; ++e)
+            live = renumber[all_edges[e].next_token];
+        for (uint32_t s = tree.skips; !live && s; s = all_skips[s].next)
+            live = renumber[all_skips[s].tree];
+        renumber[t] = live;
+    }
+    renumber[ROOT] = 1;
+    uint32_t count = 0;
+    for (uint32_t t = 1; t < all_trees.size(); ++t)
+        if (renumber[t])
+            renumber[t] = ++count;
+
+    if (mapping)
+        munmap(mapping, mapping_length);
+    mapping = 0;
+    mapping_length = 0;
+    release(nodes);
+    release(roots);
+    // the overlay usually only adds, then there is nothing to drop
+    if (count + 1 == all_trees.size()) {
+        own_trees.swap(all_trees);
+        own_skips.swap(all_skips);
+        own_edges.swap(all_edges);
+    } else {
+        own_trees.assign(1, TokenTree { 0, 0, 0, 0 });
+        own_trees.reserve(count + 1);
+        own_skips.assign(1, SkipNode(0, 0, 0));
+        own_skips.reserve(all_skips.size());
+        own_edges.assign(1, Edge { 0, 0, 0 });
+        own_edges.reserve(all_edges.size());
+        for (uint32_t t = 1; t < all_trees.size(); ++t) {
+            if (!renumber[t])
+                continue;
+            const TokenTree& tree = all_trees[t];
+            TokenTree copy = { tree.pid, 0, uint32_t(own_edges.size()), 0 };
+            for (uint32_t e = tree.edges; e < tree.edges + tree.edge_count; ++e) {
+                const Edge& edge = all_edges[e];
+                if (renumber[edge.next_token])
+                    own_edges.push_back(Edge { edge.element, renumber[edge.next_token], 0 });
+            }
+            copy.edge_count = own_edges.size() - copy.edges;
+            uint32_t last = 0;
+            for (uint32_t s = tree.skips; s; s = all_skips[s].next) {
+                if (!renumber[all_skips[s].tree])
+                    continue;
+                own_skips.emplace_back(all_skips[s].skip, renumber[all_skips[s].tree], 0);
+                uint32_t index = own_skips.size() - 1;
+                if (last)
+                    own_skips[last].next = index;
+                else
+                    copy.skips = index;
+                last = index;
+            }
+            own_trees.push_back(copy);
+        }
+    }
+    // the AA trees are only rebuilt if this one is modified
+    editable = false;
+    frozen = true;
+    sync();
+}
+
+void PatternTree::printTree(uint32_t tree) const
+{
+    if (roots.size() <= tree || roots[tree] == 0)
+        std::cerr << "Empty tree" << std::endl;
+    else
+        printTree(roots[tree], "");
+}
+
+void PatternTree::printTree(uint32_t t, const std::string& indent) const
+{
+    if (t == 0)
+        return;
+    std::string ni = indent + "  ";
+    printTree(nodes[t].left, ni);
+    fprintf(stderr, "%s(%d-%d-%d) %lu\n", indent.c_str(), nodes[t].left, t, nodes[t].right, nodes[t].element);
+    printTree(nodes[t].right, ni);
 }
 
 /**
@@ -170,16 +659,16 @@ TokenTree* TokenTree::find(uint64_t x) const
  * t is the node that roots the tree.
  * Set the new root.
  */
-int TokenTree::insert(uint64_t x, TokenTree* next_token, int t)
+uint32_t PatternTree::insert(uint64_t x, uint32_t next_token, uint32_t t)
 {
     if (t == 0) {
         nodes.emplace_back(x, next_token, 0, 0);
         t = nodes.size() - 1;
     } else if (x < nodes[t].element) {
-        int t2 = insert(x, next_token, nodes[t].left);
+        uint32_t t2 = insert(x, next_token, nodes[t].left);
         nodes[t].left = t2;
     } else if (nodes[t].element < x) {
-        int t2 = insert(x, next_token, nodes[t].right);
+        uint32_t t2 = insert(x, next_token, nodes[t].right);
         nodes[t].right = t2;
     } else {
         std::cerr << "Duplicate " << x << " ignored on insert\n";
@@ -190,41 +679,16 @@ int TokenTree::insert(uint64_t x, TokenTree* next_token, int t)
     return t;
 }
 
-void TokenTree::mark_elements(SerializeInfo& si) const
-{
-    if (skips) {
-        for (SkipList::const_iterator it = skips->begin(); it != skips->end(); ++it)
-            it->second->mark_elements(si);
-    }
-
-    if (si.trees.find(this) == si.trees.end())
-        si.trees[this] = si.tree_count++;
-
-    mark_elements(root, si);
-}
-
-void TokenTree::mark_elements(int t, SerializeInfo& si) const
-{
-    if (t == 0)
-        return;
-    mark_elements(nodes[t].left, si);
-    mark_elements(nodes[t].right, si);
-    if (si.elements.find(nodes[t].element) == si.elements.end())
-        si.elements[nodes[t].element] = si.element_count++;
-    // unlikely
-    nodes[t].next_token->mark_elements(si);
-}
-
 /**
  * Skew primitive for AA-trees.
  * t is the node that roots the tree.
  */
-int TokenTree::skew(int t)
+uint32_t PatternTree::skew(uint32_t t)
 {
     AANode& tn = nodes[t];
     AANode& ln = nodes[tn.left];
     if (ln.level == tn.level) {
-        int s = tn.left;
+        uint32_t s = tn.left;
         tn.left = ln.right;
         ln.right = t;
         return s;
@@ -236,13 +700,13 @@ int TokenTree::skew(int t)
  * Split primitive for AA-trees.
  * t is the node that roots the tree.
  */
-int TokenTree::split(int t)
+uint32_t PatternTree::split(uint32_t t)
 {
     AANode& tn = nodes[t];
     AANode& rn = nodes[tn.right];
     AANode& rrn = nodes[rn.right];
     if (rrn.level == tn.level) {
-        int s = tn.right;
+        uint32_t s = tn.right;
         tn.right = rn.left;
         rn.left = t;
         rn.level++;
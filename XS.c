@@ -0,0 +1,1581 @@
+/*
+ * This file was generated automatically by ExtUtils::ParseXS version 3.45 from the
+ * contents of XS.xs. Do not edit this file, edit XS.xs instead.
+ *
+ *    ANY CHANGES MADE HERE WILL BE LOST!
+ *
+ */
+
+#line 1 "XS.xs"
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+#include "patterns_impl.h"
+
+typedef Matcher *Spooky__Patterns__XS__Matcher;
+typedef SpookyHash *Spooky__Patterns__XS__Hash;
+typedef BagOfPatterns *Spooky__Patterns__XS__BagOfPatterns;
+typedef NearestPatterns *Spooky__Patterns__XS__NearestPatterns;
+
+#line 24 "XS.c"
+#ifndef PERL_UNUSED_VAR
+#  define PERL_UNUSED_VAR(var) if (0) var = var
+#endif
+
+#ifndef dVAR
+#  define dVAR		dNOOP
+#endif
+
+
+/* This stuff is not part of the API! You have been warned. */
+#ifndef PERL_VERSION_DECIMAL
+#  define PERL_VERSION_DECIMAL(r,v,s) (r*1000000 + v*1000 + s)
+#endif
+#ifndef PERL_DECIMAL_VERSION
+#  define PERL_DECIMAL_VERSION \
+	  PERL_VERSION_DECIMAL(PERL_REVISION,PERL_VERSION,PERL_SUBVERSION)
+#endif
+#ifndef PERL_VERSION_GE
+#  define PERL_VERSION_GE(r,v,s) \
+	  (PERL_DECIMAL_VERSION >= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+#ifndef PERL_VERSION_LE
+#  define PERL_VERSION_LE(r,v,s) \
+	  (PERL_DECIMAL_VERSION <= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+
+/* XS_INTERNAL is the explicit static-linkage variant of the default
+ * XS macro.
+ *
+ * XS_EXTERNAL is the same as XS_INTERNAL except it does not include
+ * "STATIC", ie. it exports XSUB symbols. You probably don't want that
+ * for anything but the BOOT XSUB.
+ *
+ * See XSUB.h in core!
+ */
+
+
+/* TODO: This might be compatible further back than 5.10.0. */
+#if PERL_VERSION_GE(5, 10, 0) && PERL_VERSION_LE(5, 15, 1)
+#  undef XS_EXTERNAL
+#  undef XS_INTERNAL
+#  if defined(__CYGWIN__) && defined(USE_DYNAMIC_LOADING)
+#    define XS_EXTERNAL(name) __declspec(dllexport) XSPROTO(name)
+#    define XS_INTERNAL(name) STATIC XSPROTO(name)
+#  endif
+#  if defined(__SYMBIAN32__)
+#    define XS_EXTERNAL(name) EXPORT_C XSPROTO(name)
+#    define XS_INTERNAL(name) EXPORT_C STATIC XSPROTO(name)
+#  endif
+#  ifndef XS_EXTERNAL
+#    if defined(HASATTRIBUTE_UNUSED) && !defined(__cplusplus)
+#      define XS_EXTERNAL(name) void name(pTHX_ CV* cv __attribute__unused__)
+#      define XS_INTERNAL(name) STATIC void name(pTHX_ CV* cv __attribute__unused__)
+#    else
+#      ifdef __cplusplus
+#        define XS_EXTERNAL(name) extern "C" XSPROTO(name)
+#        define XS_INTERNAL(name) static XSPROTO(name)
+#      else
+#        define XS_EXTERNAL(name) XSPROTO(name)
+#        define XS_INTERNAL(name) STATIC XSPROTO(name)
+#      endif
+#    endif
+#  endif
+#endif
+
+/* perl >= 5.10.0 && perl <= 5.15.1 */
+
+
+/* The XS_EXTERNAL macro is used for functions that must not be static
+ * like the boot XSUB of a module. If perl didn't have an XS_EXTERNAL
+ * macro defined, the best we can do is assume XS is the same.
+ * Dito for XS_INTERNAL.
+ */
+#ifndef XS_EXTERNAL
+#  define XS_EXTERNAL(name) XS(name)
+#endif
+#ifndef XS_INTERNAL
+#  define XS_INTERNAL(name) XS(name)
+#endif
+
+/* Now, finally, after all this mess, we want an ExtUtils::ParseXS
+ * internal macro that we're free to redefine for varying linkage due
+ * to the EXPORT_XSUB_SYMBOLS XS keyword. This is internal, use
+ * XS_EXTERNAL(name) or XS_INTERNAL(name) in your code if you need to!
+ */
+
+#undef XS_EUPXS
+#if defined(PERL_EUPXS_ALWAYS_EXPORT)
+#  define XS_EUPXS(name) XS_EXTERNAL(name)
+#else
+   /* default to internal */
+#  define XS_EUPXS(name) XS_INTERNAL(name)
+#endif
+
+#ifndef PERL_ARGS_ASSERT_CROAK_XS_USAGE
+#define PERL_ARGS_ASSERT_CROAK_XS_USAGE assert(cv); assert(params)
+
+/* prototype to pass -Wmissing-prototypes */
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params);
+
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params)
+{
+    const GV *const gv = CvGV(cv);
+
+    PERL_ARGS_ASSERT_CROAK_XS_USAGE;
+
+    if (gv) {
+        const char *const gvname = GvNAME(gv);
+        const HV *const stash = GvSTASH(gv);
+        const char *const hvname = stash ? HvNAME(stash) : NULL;
+
+        if (hvname)
+	    Perl_croak_nocontext("Usage: %s::%s(%s)", hvname, gvname, params);
+        else
+	    Perl_croak_nocontext("Usage: %s(%s)", gvname, params);
+    } else {
+        /* Pants. I don't think that it should be possible to get here. */
+	Perl_croak_nocontext("Usage: CODE(0x%" UVxf ")(%s)", PTR2UV(cv), params);
+    }
+}
+#undef  PERL_ARGS_ASSERT_CROAK_XS_USAGE
+
+#define croak_xs_usage        S_croak_xs_usage
+
+#endif
+
+/* NOTE: the prototype of newXSproto() is different in versions of perls,
+ * so we define a portable version of newXSproto()
+ */
+#ifdef newXS_flags
+#define newXSproto_portable(name, c_impl, file, proto) newXS_flags(name, c_impl, file, proto, 0)
+#else
+#define newXSproto_portable(name, c_impl, file, proto) (PL_Sv=(SV*)newXS(name, c_impl, file), sv_setpv(PL_Sv, proto), (CV*)PL_Sv)
+#endif /* !defined(newXS_flags) */
+
+#if PERL_VERSION_LE(5, 21, 5)
+#  define newXS_deffile(a,b) Perl_newXS(aTHX_ a,b,file)
+#else
+#  define newXS_deffile(a,b) Perl_newXS_deffile(aTHX_ a,b)
+#endif
+
+#line 168 "XS.c"
+
+XS_EUPXS(XS_Spooky__Patterns__XS_init_hash); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_init_hash)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "seed1, seed2");
+    {
+	Spooky__Patterns__XS__Hash	RETVAL;
+	UV	seed1 = (UV)SvUV(ST(0))
+;
+	UV	seed2 = (UV)SvUV(ST(1))
+;
+#line 20 "XS.xs"
+    RETVAL = pattern_init_hash(seed1, seed2);
+
+#line 185 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "Spooky::Patterns::XS::Hash", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_init_bag_of_patterns); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_init_bag_of_patterns)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	Spooky__Patterns__XS__BagOfPatterns	RETVAL;
+#line 28 "XS.xs"
+    RETVAL = pattern_init_bag_of_patterns();
+
+#line 208 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "Spooky::Patterns::XS::BagOfPatterns", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_parse_tokens); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_parse_tokens)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "str");
+    {
+	AV *	RETVAL;
+	const char *	str = (const char *)SvPV_nolen(ST(0))
+;
+#line 35 "XS.xs"
+    RETVAL = pattern_parse(str);
+
+#line 233 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_tokenizer_version); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_tokenizer_version)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	int	RETVAL;
+	dXSTARG;
+#line 42 "XS.xs"
+    RETVAL = pattern_tokenizer_version();
+
+#line 257 "XS.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_normalize); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_normalize)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "str");
+    {
+	AV *	RETVAL;
+	const char *	str = (const char *)SvPV_nolen(ST(0))
+;
+#line 49 "XS.xs"
+    RETVAL = pattern_normalize(str);
+
+#line 278 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_distance); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_distance)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "a1, a2");
+    {
+	int	RETVAL;
+	dXSTARG;
+	AV *	a1;
+	AV *	a2;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(0);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    a1 = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::distance",
+				"a1");
+		}
+	} STMT_END
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(1);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    a2 = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::distance",
+				"a2");
+		}
+	} STMT_END
+;
+#line 56 "XS.xs"
+    RETVAL = pattern_distance(a1, a2);
+
+#line 332 "XS.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_distance_within); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_distance_within)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "a1, a2, k");
+    {
+	int	RETVAL;
+	dXSTARG;
+	AV *	a1;
+	AV *	a2;
+	int	k = (int)SvIV(ST(2))
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(0);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    a1 = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::distance_within",
+				"a1");
+		}
+	} STMT_END
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(1);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    a2 = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::distance_within",
+				"a2");
+		}
+	} STMT_END
+;
+#line 63 "XS.xs"
+    RETVAL = pattern_distance_within(a1, a2, k);
+
+#line 384 "XS.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_init_nearest_patterns); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_init_nearest_patterns)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	Spooky__Patterns__XS__NearestPatterns	RETVAL;
+#line 71 "XS.xs"
+    RETVAL = pattern_init_nearest_patterns();
+
+#line 403 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "Spooky::Patterns::XS::NearestPatterns", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_init_matcher); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_init_matcher)
+{
+    dVAR; dXSARGS;
+    if (items != 0)
+       croak_xs_usage(cv,  "");
+    {
+	Spooky__Patterns__XS__Matcher	RETVAL;
+#line 78 "XS.xs"
+   RETVAL = pattern_init_matcher();
+
+#line 426 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "Spooky::Patterns::XS::Matcher", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS_read_lines); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS_read_lines)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "filename, needed");
+    {
+	AV *	RETVAL;
+	const char *	filename = (const char *)SvPV_nolen(ST(0))
+;
+	HV *	needed;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(1);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVHV){
+		    needed = (HV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not a HASH reference",
+				"Spooky::Patterns::XS::read_lines",
+				"needed");
+		}
+	} STMT_END
+;
+#line 85 "XS.xs"
+    RETVAL = pattern_read_lines(filename, needed);
+
+#line 466 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_add_pattern); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_add_pattern)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "self, id, tokens");
+    {
+	Spooky__Patterns__XS__Matcher	self;
+	unsigned int	id = (unsigned int)SvUV(ST(1))
+;
+	AV *	tokens;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::add_pattern",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(2);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    tokens = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::Matcher::add_pattern",
+				"tokens");
+		}
+	} STMT_END
+;
+#line 94 "XS.xs"
+    pattern_add(self, id, tokens);
+#line 519 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__clear); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__clear)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	Spooky__Patterns__XS__Matcher	self;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::_clear",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 99 "XS.xs"
+    pattern_clear(self);
+#line 549 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_remove_pattern); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_remove_pattern)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, id");
+    {
+	bool	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+	unsigned int	id = (unsigned int)SvUV(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::remove_pattern",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 103 "XS.xs"
+    RETVAL = pattern_remove(self, id);
+
+#line 583 "XS.c"
+	ST(0) = boolSV(RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "self, filename, engine");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+	const char *	filename = (const char *)SvPV_nolen(ST(1))
+;
+	int	engine = (int)SvIV(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::_find_matches",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 110 "XS.xs"
+    RETVAL = pattern_find_matches(self, filename, engine);
+
+#line 620 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches_batch); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches_batch)
+{
+    dVAR; dXSARGS;
+    if (items != 4)
+       croak_xs_usage(cv,  "self, filenames, threads, engine");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+	AV *	filenames;
+	int	threads = (int)SvIV(ST(2))
+;
+	int	engine = (int)SvIV(ST(3))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::_find_matches_batch",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(1);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    filenames = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::Matcher::_find_matches_batch",
+				"filenames");
+		}
+	} STMT_END
+;
+#line 117 "XS.xs"
+    RETVAL = pattern_find_matches_batch(self, filenames, threads, engine);
+
+#line 677 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches_in_string); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches_in_string)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "self, text, engine");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+	SV *	text = ST(1)
+;
+	int	engine = (int)SvIV(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::_find_matches_in_string",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 124 "XS.xs"
+    RETVAL = pattern_find_matches_in_string(self, text, engine);
+
+#line 719 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches_in_fd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__find_matches_in_fd)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "self, fd, engine");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+	int	fd = (int)SvIV(ST(1))
+;
+	int	engine = (int)SvIV(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::_find_matches_in_fd",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 131 "XS.xs"
+    RETVAL = pattern_find_matches_in_fd(self, fd, engine);
+
+#line 761 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__stats); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher__stats)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::_stats",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 138 "XS.xs"
+    RETVAL = pattern_stats(self);
+
+#line 799 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_dump); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_dump)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, filename");
+    {
+	bool	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+	const char *	filename = (const char *)SvPV_nolen(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::dump",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 145 "XS.xs"
+    RETVAL = pattern_dump(self, filename);
+
+#line 839 "XS.c"
+	ST(0) = boolSV(RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_load); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_load)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, filename");
+    {
+	bool	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+	const char *	filename = (const char *)SvPV_nolen(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::load",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 152 "XS.xs"
+    RETVAL = pattern_load(self, filename);
+
+#line 874 "XS.c"
+	ST(0) = boolSV(RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_compact); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_compact)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, filename");
+    {
+	Spooky__Patterns__XS__Matcher	self;
+	const char *	filename = (const char *)SvPV_nolen(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::compact",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 160 "XS.xs"
+    pattern_compact(self, filename);
+#line 907 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_wait_compaction); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_wait_compaction)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	bool	RETVAL;
+	Spooky__Patterns__XS__Matcher	self;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Matcher")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Matcher::wait_compaction",
+			"self", "Spooky::Patterns::XS::Matcher",
+			refstr, ST(0)
+		);
+	}
+;
+#line 164 "XS.xs"
+    RETVAL = pattern_wait_compaction(self);
+
+#line 939 "XS.c"
+	ST(0) = boolSV(RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Matcher_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	Spooky__Patterns__XS__Matcher	self;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Matcher,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"Spooky::Patterns::XS::Matcher::DESTROY",
+			"self")
+;
+#line 171 "XS.xs"
+   destroy_matcher(self);
+#line 966 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Hash_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Hash_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	Spooky__Patterns__XS__Hash	self;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Hash,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"Spooky::Patterns::XS::Hash::DESTROY",
+			"self")
+;
+#line 177 "XS.xs"
+    destroy_hash(self);
+#line 992 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Hash_add); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Hash_add)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, s");
+    {
+	Spooky__Patterns__XS__Hash	self;
+	SV *	s = ST(1)
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Hash")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Hash,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Hash::add",
+			"self", "Spooky::Patterns::XS::Hash",
+			refstr, ST(0)
+		);
+	}
+;
+#line 181 "XS.xs"
+    pattern_add_to_hash(self, s);
+#line 1024 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__Hash_hash128); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__Hash_hash128)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__Hash	self;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::Hash")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__Hash,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::Hash::hash128",
+			"self", "Spooky::Patterns::XS::Hash",
+			refstr, ST(0)
+		);
+	}
+;
+#line 185 "XS.xs"
+    RETVAL = pattern_hash128(self);
+
+#line 1056 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	Spooky__Patterns__XS__BagOfPatterns	self;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"Spooky::Patterns::XS::BagOfPatterns::DESTROY",
+			"self")
+;
+#line 194 "XS.xs"
+    destroy_bag_of_patterns(self);
+#line 1088 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns__set_patterns); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns__set_patterns)
+{
+    dVAR; dXSARGS;
+    if (items != 4)
+       croak_xs_usage(cv,  "self, patterns, float_weights, threads");
+    {
+	Spooky__Patterns__XS__BagOfPatterns	self;
+	HV *	patterns;
+	bool	float_weights = (bool)SvTRUE(ST(2))
+;
+	int	threads = (int)SvIV(ST(3))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::BagOfPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::BagOfPatterns::_set_patterns",
+			"self", "Spooky::Patterns::XS::BagOfPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(1);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVHV){
+		    patterns = (HV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not a HASH reference",
+				"Spooky::Patterns::XS::BagOfPatterns::_set_patterns",
+				"patterns");
+		}
+	} STMT_END
+;
+#line 198 "XS.xs"
+    pattern_bag_set_patterns(self, patterns, float_weights, threads);
+#line 1137 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_best_for); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_best_for)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "self, str, count");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__BagOfPatterns	self;
+	const char *	str = (const char *)SvPV_nolen(ST(1))
+;
+	int	count = (int)SvIV(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::BagOfPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::BagOfPatterns::best_for",
+			"self", "Spooky::Patterns::XS::BagOfPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+#line 202 "XS.xs"
+    RETVAL = pattern_bag_best_for(self, str, count);
+
+#line 1173 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns__best_for_many); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns__best_for_many)
+{
+    dVAR; dXSARGS;
+    if (items != 4)
+       croak_xs_usage(cv,  "self, snippets, count, threads");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__BagOfPatterns	self;
+	AV *	snippets;
+	int	count = (int)SvIV(ST(2))
+;
+	int	threads = (int)SvIV(ST(3))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::BagOfPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::BagOfPatterns::_best_for_many",
+			"self", "Spooky::Patterns::XS::BagOfPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(1);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    snippets = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::BagOfPatterns::_best_for_many",
+				"snippets");
+		}
+	} STMT_END
+;
+#line 209 "XS.xs"
+    RETVAL = pattern_bag_best_for_many(self, snippets, count, threads);
+
+#line 1230 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_add_pattern); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_add_pattern)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "self, id, text");
+    {
+	Spooky__Patterns__XS__BagOfPatterns	self;
+	unsigned int	id = (unsigned int)SvUV(ST(1))
+;
+	const char *	text = (const char *)SvPV_nolen(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::BagOfPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::BagOfPatterns::add_pattern",
+			"self", "Spooky::Patterns::XS::BagOfPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+#line 217 "XS.xs"
+    pattern_bag_add_pattern(self, id, text);
+#line 1270 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_remove_pattern); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_remove_pattern)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, id");
+    {
+	bool	RETVAL;
+	Spooky__Patterns__XS__BagOfPatterns	self;
+	unsigned int	id = (unsigned int)SvUV(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::BagOfPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::BagOfPatterns::remove_pattern",
+			"self", "Spooky::Patterns::XS::BagOfPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+#line 221 "XS.xs"
+    RETVAL = pattern_bag_remove_pattern(self, id);
+
+#line 1304 "XS.c"
+	ST(0) = boolSV(RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_dump); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_dump)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, filename");
+    {
+	Spooky__Patterns__XS__BagOfPatterns	self;
+	const char *	filename = (const char *)SvPV_nolen(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::BagOfPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::BagOfPatterns::dump",
+			"self", "Spooky::Patterns::XS::BagOfPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+#line 228 "XS.xs"
+    pattern_bag_dump(self, filename);
+#line 1337 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_load); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__BagOfPatterns_load)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "self, filename");
+    {
+	bool	RETVAL;
+	Spooky__Patterns__XS__BagOfPatterns	self;
+	const char *	filename = (const char *)SvPV_nolen(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::BagOfPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__BagOfPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::BagOfPatterns::load",
+			"self", "Spooky::Patterns::XS::BagOfPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+#line 232 "XS.xs"
+    RETVAL = pattern_bag_load(self, filename);
+
+#line 1371 "XS.c"
+	ST(0) = boolSV(RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__NearestPatterns_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__NearestPatterns_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "self");
+    {
+	Spooky__Patterns__XS__NearestPatterns	self;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__NearestPatterns,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"Spooky::Patterns::XS::NearestPatterns::DESTROY",
+			"self")
+;
+#line 241 "XS.xs"
+    destroy_nearest_patterns(self);
+#line 1398 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__NearestPatterns_add_pattern); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__NearestPatterns_add_pattern)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "self, id, tokens");
+    {
+	Spooky__Patterns__XS__NearestPatterns	self;
+	unsigned int	id = (unsigned int)SvUV(ST(1))
+;
+	AV *	tokens;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::NearestPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__NearestPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::NearestPatterns::add_pattern",
+			"self", "Spooky::Patterns::XS::NearestPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(2);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    tokens = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::NearestPatterns::add_pattern",
+				"tokens");
+		}
+	} STMT_END
+;
+#line 245 "XS.xs"
+    pattern_nearest_add(self, id, tokens);
+#line 1445 "XS.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_Spooky__Patterns__XS__NearestPatterns__nearest); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_Spooky__Patterns__XS__NearestPatterns__nearest)
+{
+    dVAR; dXSARGS;
+    if (items != 4)
+       croak_xs_usage(cv,  "self, tokens, count, threads");
+    {
+	AV *	RETVAL;
+	Spooky__Patterns__XS__NearestPatterns	self;
+	AV *	tokens;
+	int	count = (int)SvIV(ST(2))
+;
+	int	threads = (int)SvIV(ST(3))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "Spooky::Patterns::XS::NearestPatterns")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    self = INT2PTR(Spooky__Patterns__XS__NearestPatterns,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"Spooky::Patterns::XS::NearestPatterns::_nearest",
+			"self", "Spooky::Patterns::XS::NearestPatterns",
+			refstr, ST(0)
+		);
+	}
+;
+
+	STMT_START {
+		SV* const xsub_tmp_sv = ST(1);
+		SvGETMAGIC(xsub_tmp_sv);
+		if (SvROK(xsub_tmp_sv) && SvTYPE(SvRV(xsub_tmp_sv)) == SVt_PVAV){
+		    tokens = (AV*)SvRV(xsub_tmp_sv);
+		}
+		else{
+		    Perl_croak_nocontext("%s: %s is not an ARRAY reference",
+				"Spooky::Patterns::XS::NearestPatterns::_nearest",
+				"tokens");
+		}
+	} STMT_END
+;
+#line 249 "XS.xs"
+    RETVAL = pattern_nearest(self, tokens, count, threads);
+
+#line 1496 "XS.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = newRV_noinc((SV*)RETVAL);
+	    RETVALSV = sv_2mortal(RETVALSV);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+XS_EXTERNAL(boot_Spooky__Patterns__XS); /* prototype to pass -Wmissing-prototypes */
+XS_EXTERNAL(boot_Spooky__Patterns__XS)
+{
+#if PERL_VERSION_LE(5, 21, 5)
+    dVAR; dXSARGS;
+#else
+    dVAR; dXSBOOTARGSXSAPIVERCHK;
+#endif
+#if PERL_VERSION_LE(5, 8, 999) /* PERL_VERSION_LT is 5.33+ */
+    char* file = __FILE__;
+#else
+    const char* file = __FILE__;
+#endif
+
+    PERL_UNUSED_VAR(file);
+
+    PERL_UNUSED_VAR(cv); /* -W */
+    PERL_UNUSED_VAR(items); /* -W */
+#if PERL_VERSION_LE(5, 21, 5)
+    XS_VERSION_BOOTCHECK;
+#  ifdef XS_APIVERSION_BOOTCHECK
+    XS_APIVERSION_BOOTCHECK;
+#  endif
+#endif
+
+        (void)newXSproto_portable("Spooky::Patterns::XS::init_hash", XS_Spooky__Patterns__XS_init_hash, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::init_bag_of_patterns", XS_Spooky__Patterns__XS_init_bag_of_patterns, file, "");
+        (void)newXSproto_portable("Spooky::Patterns::XS::parse_tokens", XS_Spooky__Patterns__XS_parse_tokens, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::tokenizer_version", XS_Spooky__Patterns__XS_tokenizer_version, file, "");
+        (void)newXSproto_portable("Spooky::Patterns::XS::normalize", XS_Spooky__Patterns__XS_normalize, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::distance", XS_Spooky__Patterns__XS_distance, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::distance_within", XS_Spooky__Patterns__XS_distance_within, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::init_nearest_patterns", XS_Spooky__Patterns__XS_init_nearest_patterns, file, "");
+        (void)newXSproto_portable("Spooky::Patterns::XS::init_matcher", XS_Spooky__Patterns__XS_init_matcher, file, "");
+        (void)newXSproto_portable("Spooky::Patterns::XS::read_lines", XS_Spooky__Patterns__XS_read_lines, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::add_pattern", XS_Spooky__Patterns__XS__Matcher_add_pattern, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::_clear", XS_Spooky__Patterns__XS__Matcher__clear, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::remove_pattern", XS_Spooky__Patterns__XS__Matcher_remove_pattern, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::_find_matches", XS_Spooky__Patterns__XS__Matcher__find_matches, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::_find_matches_batch", XS_Spooky__Patterns__XS__Matcher__find_matches_batch, file, "$$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::_find_matches_in_string", XS_Spooky__Patterns__XS__Matcher__find_matches_in_string, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::_find_matches_in_fd", XS_Spooky__Patterns__XS__Matcher__find_matches_in_fd, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::_stats", XS_Spooky__Patterns__XS__Matcher__stats, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::dump", XS_Spooky__Patterns__XS__Matcher_dump, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::load", XS_Spooky__Patterns__XS__Matcher_load, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::compact", XS_Spooky__Patterns__XS__Matcher_compact, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::wait_compaction", XS_Spooky__Patterns__XS__Matcher_wait_compaction, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Matcher::DESTROY", XS_Spooky__Patterns__XS__Matcher_DESTROY, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Hash::DESTROY", XS_Spooky__Patterns__XS__Hash_DESTROY, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Hash::add", XS_Spooky__Patterns__XS__Hash_add, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::Hash::hash128", XS_Spooky__Patterns__XS__Hash_hash128, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::DESTROY", XS_Spooky__Patterns__XS__BagOfPatterns_DESTROY, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::_set_patterns", XS_Spooky__Patterns__XS__BagOfPatterns__set_patterns, file, "$$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::best_for", XS_Spooky__Patterns__XS__BagOfPatterns_best_for, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::_best_for_many", XS_Spooky__Patterns__XS__BagOfPatterns__best_for_many, file, "$$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::add_pattern", XS_Spooky__Patterns__XS__BagOfPatterns_add_pattern, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::remove_pattern", XS_Spooky__Patterns__XS__BagOfPatterns_remove_pattern, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::dump", XS_Spooky__Patterns__XS__BagOfPatterns_dump, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::BagOfPatterns::load", XS_Spooky__Patterns__XS__BagOfPatterns_load, file, "$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::NearestPatterns::DESTROY", XS_Spooky__Patterns__XS__NearestPatterns_DESTROY, file, "$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::NearestPatterns::add_pattern", XS_Spooky__Patterns__XS__NearestPatterns_add_pattern, file, "$$$");
+        (void)newXSproto_portable("Spooky::Patterns::XS::NearestPatterns::_nearest", XS_Spooky__Patterns__XS__NearestPatterns__nearest, file, "$$$$");
+#if PERL_VERSION_LE(5, 21, 5)
+#  if PERL_VERSION_GE(5, 9, 0)
+    if (PL_unitcheckav)
+        call_list(PL_scopestack_ix, PL_unitcheckav);
+#  endif
+    XSRETURN_YES;
+#else
+    Perl_xs_boot_epilog(aTHX_ ax);
+#endif
+}
+
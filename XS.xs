@@ -9,6 +9,7 @@
 typedef Matcher *Spooky__Patterns__XS__Matcher;
 typedef SpookyHash *Spooky__Patterns__XS__Hash;
 typedef BagOfPatterns *Spooky__Patterns__XS__BagOfPatterns;
+typedef NearestPatterns *Spooky__Patterns__XS__NearestPatterns;
 
 MODULE = Spooky::Patterns::XS  PACKAGE = Spooky::Patterns::XS
 
@@ -36,6 +37,13 @@ AV *parse_tokens(const char *str)
   OUTPUT:
     RETVAL
 
+int tokenizer_version()
+  CODE:
+    RETVAL = pattern_tokenizer_version();
+
+  OUTPUT:
+    RETVAL
+
 AV *normalize(const char *str)
   CODE:
     RETVAL = pattern_normalize(str);
@@ -50,6 +58,21 @@ int distance(AV *a1, AV *a2)
   OUTPUT:
     RETVAL
 
+int distance_within(AV *a1, AV *a2, int k)
+  CODE:
+    RETVAL = pattern_distance_within(a1, a2, k);
+
+  OUTPUT:
+    RETVAL
+
+# patterns are added as normalize results
+Spooky::Patterns::XS::NearestPatterns init_nearest_patterns()
+  CODE:
+    RETVAL = pattern_init_nearest_patterns();
+
+  OUTPUT:
+    RETVAL
+
 Spooky::Patterns::XS::Matcher init_matcher()
   CODE:
    RETVAL = pattern_init_matcher();
@@ -70,20 +93,78 @@ void add_pattern(Spooky::Patterns::XS::Matcher self, unsigned int id, AV *tokens
   CODE:
     pattern_add(self, id, tokens);
 
-AV *find_matches(Spooky::Patterns::XS::Matcher self, const char *filename)
+# drop all patterns
+void _clear(Spooky::Patterns::XS::Matcher self)
   CODE:
-    RETVAL = pattern_find_matches(self, filename);
+    pattern_clear(self);
+
+bool remove_pattern(Spooky::Patterns::XS::Matcher self, unsigned int id)
+  CODE:
+    RETVAL = pattern_remove(self, id);
 
   OUTPUT:
     RETVAL
 
-void dump(Spooky::Patterns::XS::Matcher self, const char *filename)
+AV *_find_matches(Spooky::Patterns::XS::Matcher self, const char *filename, int engine)
   CODE:
-    pattern_dump(self, filename);
+    RETVAL = pattern_find_matches(self, filename, engine);
+
+  OUTPUT:
+    RETVAL
 
-void load(Spooky::Patterns::XS::Matcher self, const char *filename)
+AV *_find_matches_batch(Spooky::Patterns::XS::Matcher self, AV *filenames, int threads, int engine)
   CODE:
-    pattern_load(self, filename);
+    RETVAL = pattern_find_matches_batch(self, filenames, threads, engine);
+
+  OUTPUT:
+    RETVAL
+
+AV *_find_matches_in_string(Spooky::Patterns::XS::Matcher self, SV *text, int engine)
+  CODE:
+    RETVAL = pattern_find_matches_in_string(self, text, engine);
+
+  OUTPUT:
+    RETVAL
+
+AV *_find_matches_in_fd(Spooky::Patterns::XS::Matcher self, int fd, int engine)
+  CODE:
+    RETVAL = pattern_find_matches_in_fd(self, fd, engine);
+
+  OUTPUT:
+    RETVAL
+
+AV *_stats(Spooky::Patterns::XS::Matcher self)
+  CODE:
+    RETVAL = pattern_stats(self);
+
+  OUTPUT:
+    RETVAL
+
+bool dump(Spooky::Patterns::XS::Matcher self, const char *filename)
+  CODE:
+    RETVAL = pattern_dump(self, filename);
+
+  OUTPUT:
+    RETVAL
+
+bool load(Spooky::Patterns::XS::Matcher self, const char *filename)
+  CODE:
+    RETVAL = pattern_load(self, filename);
+
+  OUTPUT:
+    RETVAL
+
+# dump in a native thread, the matcher can be used for matches meanwhile
+void compact(Spooky::Patterns::XS::Matcher self, const char *filename)
+  CODE:
+    pattern_compact(self, filename);
+
+bool wait_compaction(Spooky::Patterns::XS::Matcher self)
+  CODE:
+    RETVAL = pattern_wait_compaction(self);
+
+  OUTPUT:
+    RETVAL
 
 void DESTROY(Spooky::Patterns::XS::Matcher self)
   CODE:
@@ -112,9 +193,9 @@ void DESTROY(Spooky::Patterns::XS::BagOfPatterns self)
   CODE:
     destroy_bag_of_patterns(self);
 
-void set_patterns(Spooky::Patterns::XS::BagOfPatterns self, HV *patterns)
+void _set_patterns(Spooky::Patterns::XS::BagOfPatterns self, HV *patterns, bool float_weights, int threads)
   CODE:
-    pattern_bag_set_patterns(self, patterns);
+    pattern_bag_set_patterns(self, patterns, float_weights, threads);
 
 AV *best_for(Spooky::Patterns::XS::BagOfPatterns self, const char *str, int count)
   CODE:
@@ -123,6 +204,25 @@ AV *best_for(Spooky::Patterns::XS::BagOfPatterns self, const char *str, int coun
   OUTPUT:
     RETVAL
 
+AV *_best_for_many(Spooky::Patterns::XS::BagOfPatterns self, AV *snippets, int count, int threads)
+  CODE:
+    RETVAL = pattern_bag_best_for_many(self, snippets, count, threads);
+
+  OUTPUT:
+    RETVAL
+
+# set_patterns without tokenizing all the others again
+void add_pattern(Spooky::Patterns::XS::BagOfPatterns self, unsigned int id, const char *text)
+  CODE:
+    pattern_bag_add_pattern(self, id, text);
+
+bool remove_pattern(Spooky::Patterns::XS::BagOfPatterns self, unsigned int id)
+  CODE:
+    RETVAL = pattern_bag_remove_pattern(self, id);
+
+  OUTPUT:
+    RETVAL
+
 void dump(Spooky::Patterns::XS::BagOfPatterns self, const char *filename)
   CODE:
     pattern_bag_dump(self, filename);
@@ -133,3 +233,20 @@ bool load(Spooky::Patterns::XS::BagOfPatterns self, const char *filename)
 
   OUTPUT:
     RETVAL
+
+MODULE = Spooky::Patterns::XS PACKAGE = Spooky::Patterns::XS::NearestPatterns PREFIX = NearestPatterns
+
+void DESTROY(Spooky::Patterns::XS::NearestPatterns self)
+  CODE:
+    destroy_nearest_patterns(self);
+
+void add_pattern(Spooky::Patterns::XS::NearestPatterns self, unsigned int id, AV *tokens)
+  CODE:
+    pattern_nearest_add(self, id, tokens);
+
+AV *_nearest(Spooky::Patterns::XS::NearestPatterns self, AV *tokens, int count, int threads)
+  CODE:
+    RETVAL = pattern_nearest(self, tokens, count, threads);
+
+  OUTPUT:
+    RETVAL
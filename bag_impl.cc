@@ -14,69 +14,148 @@
 // with this program; if not, see <http://www.gnu.org/licenses/>.
 
 #include "Matcher.h"
+#include "Parallel.h"
+#include "SpookyV2.h"
 #include "patterns_impl.h"
 #include <EXTERN.h>
 #include <XSUB.h>
 // work around seed
 #undef seed
 #include <algorithm>
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <map>
 #include <perl.h>
 #include <set>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
 
 #define DEBUG 0
 
 using namespace std;
 
-typedef map<uint64_t, uint64_t> wordmap;
-
 // https://en.wikipedia.org/wiki/Tf%E2%80%93idf
-struct TfIdf {
+// A snippet as the positions of its words in the bag and their values.
+// The words of the bag are sorted by hash, so these are too
+struct BagQuery {
+    vector<uint32_t> words;
+    vector<double> values;
+};
+
+// A word of the bag, sorted by hash. Its patterns are postings[first_posting]
+// to postings[first_posting + posting_count - 1], by ascending square sum
+struct BagWord {
     uint64_t hash;
-    double value;
-    TfIdf(uint64_t _hash, double _value)
-    {
-        hash = _hash;
-        value = _value;
-    }
-    bool operator<(const TfIdf& str) const
-    {
-        return (hash < str.hash);
-    }
+    double idf;
+    // the highest value of the word in any of its patterns
+    double max_value;
+    uint32_t first_posting;
+    uint32_t posting_count;
 };
 
-struct Pattern {
+// A pattern of the bag, sorted by index. Its words are value_words[first]
+// to value_words[first + count - 1] (positions in words, so sorted by hash)
+// with their tf-idf in values or float_values
+struct BagPattern {
     uint64_t index;
     double square_sum;
-    vector<TfIdf> tf_idfs;
+    uint32_t first;
+    uint32_t count;
+};
+
+// the dump format depends on these
+static_assert(sizeof(BagWord) == 32, "BagWord layout");
+static_assert(sizeof(BagPattern) == 24, "BagPattern layout");
+
+// A slot of the open addressing table to find words by hash, word is
+// the position in words + 1 or 0 for an empty slot
+struct BagWordSlot {
+    uint64_t hash;
+    uint32_t word;
+};
+
+struct BagHit {
+    double match;
+    // the position in patterns
+    uint32_t pattern;
 };
 
 class BagOfPatterns {
 public:
-    BagOfPatterns() {}
-    void set_patterns(HV* patterns);
+    BagOfPatterns();
+    ~BagOfPatterns();
+    void set_patterns(HV* patterns, bool float_weights, unsigned int threads);
+    void add_pattern(uint64_t id, const char* text);
+    bool remove_pattern(uint64_t id);
     AV* best_for(const string& snippet, unsigned int count);
-    void dump(const char* filename) const;
+    AV* best_for_many(AV* snippets, unsigned int count, unsigned int threads);
+    void dump(const char* filename);
     bool load(const char* filename);
 
 private:
-    void tokenize(const char* str, wordmap& localwords);
-    double compare2(const vector<TfIdf>& tfdif1, const Pattern& pattern) const;
-    double tf_idf(const wordmap& l1, vector<TfIdf>& tfdif1);
-
-    map<uint64_t, double> idfs;
-    vector<Pattern> patterns;
+    void tokenize(const char* str, vector<uint64_t>& hashes) const;
+    double compare2(const BagQuery& query, const BagPattern& pattern) const;
+    double tf_idf(const vector<uint64_t>& hashes, BagQuery& query) const;
+    const BagWord* find_word(uint64_t hash) const;
+    double best_hits(const string& snippet, unsigned int count, vector<BagHit>& hits) const;
+    AV* hits_to_av(const vector<BagHit>& hits, double square_sum) const;
+    void sync();
+    void release();
+    void index_words();
+    void build(unsigned int threads);
+    void unshare();
+    void update();
+
+    // the arrays are either our own vectors or point into a mapped dump
+    const BagWord* words;
+    uint32_t word_count;
+    const BagPattern* patterns;
+    uint32_t pattern_count;
+    const uint32_t* value_words;
+    // only one of them is used, float halves the size of the bag
+    const double* values;
+    const float* float_values;
+    uint64_t value_count;
+    const uint32_t* postings;
+    uint64_t posting_count;
+
+    vector<BagWord> own_words;
+    vector<BagPattern> own_patterns;
+    vector<uint32_t> own_value_words;
+    vector<double> own_values;
+    vector<float> own_float_values;
+    vector<uint32_t> own_postings;
+    // rebuilt from words by sync and load, not part of the dump
+    vector<BagWordSlot> word_slots;
+    bool use_float;
+
+    // The words of every pattern by ID and in how many patterns every
+    // word is. Only kept once patterns are added or removed, the arrays
+    // are rebuilt from them before they are used next
+    map<uint64_t, vector<uint64_t>> pattern_words;
+    unordered_map<uint64_t, uint32_t> document_counts;
+    bool editable;
+    bool dirty;
+
+    void* mapping;
+    size_t mapping_length;
 #if DEBUG
-    map<uint64_t, string> debugwords;
+    mutable map<uint64_t, string> debugwords;
 #endif
+
+    // forbidden
+    BagOfPatterns(const BagOfPatterns& rhs);
+    const BagOfPatterns& operator=(const BagOfPatterns& rhs);
 };
 
 BagOfPatterns* pattern_init_bag_of_patterns() { return new BagOfPatterns(); }
 
-void pattern_bag_set_patterns(BagOfPatterns* b, HV* patterns)
+void pattern_bag_set_patterns(BagOfPatterns* b, HV* patterns, bool float_weights, int threads)
 {
-    b->set_patterns(patterns);
+    b->set_patterns(patterns, float_weights, threads > 0 ? threads : 1);
 }
 
 void destroy_bag_of_patterns(BagOfPatterns* b) { delete b; }
@@ -86,6 +165,11 @@ AV* pattern_bag_best_for(BagOfPatterns* b, const char* str, int count)
     return b->best_for(str, count);
 }
 
+AV* pattern_bag_best_for_many(BagOfPatterns* b, AV* snippets, int count, int threads)
+{
+    return b->best_for_many(snippets, count > 0 ? count : 0, threads > 0 ? threads : 1);
+}
+
 void pattern_bag_dump(BagOfPatterns* b, const char* filename)
 {
     b->dump(filename);
@@ -96,15 +180,89 @@ bool pattern_bag_load(BagOfPatterns* b, const char* filename)
     return b->load(filename);
 }
 
-void BagOfPatterns::set_patterns(HV* hv_patterns)
+void pattern_bag_add_pattern(BagOfPatterns* b, unsigned int id, const char* text)
+{
+    b->add_pattern(id, text);
+}
+
+bool pattern_bag_remove_pattern(BagOfPatterns* b, unsigned int id)
 {
-    idfs.clear();
-    patterns.clear();
+    return b->remove_pattern(id);
+}
 
-    wordmap words;
-    vector<wordmap> wordcounts;
-    vector<uint64_t> indexes;
+BagOfPatterns::BagOfPatterns()
+{
+    mapping = 0;
+    mapping_length = 0;
+    use_float = false;
+    editable = false;
+    dirty = false;
+    sync();
+}
 
+BagOfPatterns::~BagOfPatterns()
+{
+    if (mapping)
+        munmap(mapping, mapping_length);
+}
+
+void BagOfPatterns::sync()
+{
+    words = own_words.data();
+    word_count = own_words.size();
+    patterns = own_patterns.data();
+    pattern_count = own_patterns.size();
+    value_words = own_value_words.data();
+    values = own_float_values.empty() ? own_values.data() : 0;
+    float_values = own_float_values.empty() ? 0 : own_float_values.data();
+    value_count = own_value_words.size();
+    postings = own_postings.data();
+    posting_count = own_postings.size();
+    index_words();
+}
+
+void BagOfPatterns::index_words()
+{
+    // at most half full, so the probe sequences stay short
+    size_t size = 16;
+    while (size < 2 * size_t(word_count))
+        size *= 2;
+    word_slots.assign(size, BagWordSlot { 0, 0 });
+    for (uint32_t w = 0; w < word_count; ++w) {
+        // the hashes are SpookyHash, the low bits are as good as any
+        size_t i = words[w].hash & (size - 1);
+        while (word_slots[i].word)
+            i = (i + 1) & (size - 1);
+        word_slots[i] = BagWordSlot { words[w].hash, w + 1 };
+    }
+}
+
+template <typename T>
+static void release_vector(vector<T>& v)
+{
+    vector<T>().swap(v);
+}
+
+void BagOfPatterns::release()
+{
+    if (mapping)
+        munmap(mapping, mapping_length);
+    mapping = 0;
+    mapping_length = 0;
+    release_vector(own_words);
+    release_vector(own_patterns);
+    release_vector(own_value_words);
+    release_vector(own_values);
+    release_vector(own_float_values);
+    release_vector(own_postings);
+    sync();
+}
+
+// The texts are copied out of perl first, everything else runs on up
+// to threads native threads
+void BagOfPatterns::set_patterns(HV* hv_patterns, bool float_weights, unsigned int threads)
+{
+    vector<pair<uint64_t, string>> texts;
     hv_iterinit(hv_patterns);
     HE* he;
     while ((he = hv_iternext(hv_patterns)) != 0) {
@@ -116,127 +274,425 @@ void BagOfPatterns::set_patterns(HV* hv_patterns)
         if (!svp)
             continue;
 
-        wordmap localwords;
-        tokenize(SvPV_nolen(svp), localwords);
-        indexes.push_back(index);
-        wordcounts.push_back(localwords);
-
-        for (wordmap::const_iterator it = localwords.begin(); it != localwords.end(); ++it) {
-            wordmap::iterator word_it = words.find(it->first);
-            if (word_it == words.end())
-                words[it->first] = 1;
-            else
-                word_it->second++;
-        }
+        STRLEN textlen;
+        const char* text = SvPV(svp, textlen);
+        texts.emplace_back(index, string(text, textlen));
     }
-    for (wordmap::const_iterator it = words.begin(); it != words.end(); ++it) {
-        idfs[it->first] = log(double(indexes.size()) / it->second);
+    // keys like "1" and "01" are the same ID, only one of them is kept
+    stable_sort(texts.begin(), texts.end(), [](const pair<uint64_t, string>& a, const pair<uint64_t, string>& b) {
+        return a.first < b.first;
+    });
+    texts.erase(unique(texts.begin(), texts.end(), [](const pair<uint64_t, string>& a, const pair<uint64_t, string>& b) {
+        return a.first == b.first;
+    }),
+        texts.end());
+
 #if DEBUG
-        cerr << int(idfs[it->first] * 1000) << " " << indexes.size() << " "
-             << it->second << " " << debugwords[it->first] << endl;
+    // debugwords is not locked
+    threads = 1;
 #endif
+    vector<vector<uint64_t>> hashes(texts.size());
+    parallel_for(texts.size(), threads, [&](size_t i) {
+        tokenize(texts[i].second.c_str(), hashes[i]);
+        string().swap(texts[i].second);
+    });
+
+    // every thread counts the words of a slice of the patterns, the
+    // tables are merged afterwards
+    size_t slices = min<size_t>(max(threads, 1u), hashes.size());
+    vector<unordered_map<uint64_t, uint32_t>> slice_counts(slices);
+    parallel_for(slices, threads, [&](size_t t) {
+        size_t end = hashes.size() * (t + 1) / slices;
+        for (size_t i = hashes.size() * t / slices; i < end; ++i)
+            for (uint64_t hash : hashes[i])
+                slice_counts[t][hash]++;
+    });
+
+    pattern_words.clear();
+    document_counts.clear();
+    editable = true;
+    if (slices)
+        document_counts.swap(slice_counts[0]);
+    for (size_t t = 1; t < slices; ++t)
+        for (const auto& c : slice_counts[t])
+            document_counts[c.first] += c.second;
+    for (size_t i = 0; i < texts.size(); ++i)
+        pattern_words.emplace_hint(pattern_words.end(), texts[i].first, vector<uint64_t>())->second.swap(hashes[i]);
+
+    use_float = float_weights;
+    build(threads);
+    // only needed to add or remove patterns later, it can be recreated
+    map<uint64_t, vector<uint64_t>>().swap(pattern_words);
+    unordered_map<uint64_t, uint32_t>().swap(document_counts);
+    editable = false;
+    dirty = false;
+}
+
+/**
+ * Get the words of every pattern back from the arrays before modifying
+ * them - like that the patterns don't need to be tokenized again.
+ */
+void BagOfPatterns::unshare()
+{
+    if (editable)
+        return;
+    pattern_words.clear();
+    document_counts.clear();
+    for (uint32_t i = 0; i < pattern_count; ++i) {
+        const BagPattern& p = patterns[i];
+        vector<uint64_t>& hashes = pattern_words.emplace_hint(pattern_words.end(), p.index, vector<uint64_t>())->second;
+        hashes.reserve(p.count);
+        for (uint32_t v = p.first; v < p.first + p.count; ++v) {
+            uint64_t hash = words[value_words[v]].hash;
+            hashes.push_back(hash);
+            document_counts[hash]++;
+        }
     }
+    editable = true;
+}
+
+void BagOfPatterns::add_pattern(uint64_t id, const char* text)
+{
+    remove_pattern(id);
 
-    vector<uint64_t>::const_iterator index_it = indexes.begin();
-    vector<wordmap>::const_iterator words_it = wordcounts.begin();
-    for (; words_it != wordcounts.end(); ++words_it, ++index_it) {
-        Pattern p;
-        p.index = *index_it;
-        p.square_sum = tf_idf(*words_it, p.tf_idfs);
-        patterns.push_back(p);
+    vector<uint64_t>& hashes = pattern_words[id];
+    tokenize(text, hashes);
+    for (uint64_t hash : hashes)
+        document_counts[hash]++;
+    dirty = true;
+}
+
+bool BagOfPatterns::remove_pattern(uint64_t id)
+{
+    unshare();
+    map<uint64_t, vector<uint64_t>>::iterator it = pattern_words.find(id);
+    if (it == pattern_words.end())
+        return false;
+    for (uint64_t hash : it->second) {
+        unordered_map<uint64_t, uint32_t>::iterator count = document_counts.find(hash);
+        if (!--count->second)
+            document_counts.erase(count);
     }
+    pattern_words.erase(it);
+    dirty = true;
+    return true;
 }
 
-void BagOfPatterns::tokenize(const char* str, wordmap& localwords)
+void BagOfPatterns::update()
 {
-    char* copy = strdup(str);
-    TokenList t;
-    Matcher::self()->tokenize(t, copy, 1);
-    free(copy);
+    if (!dirty)
+        return;
+    build(1);
+    dirty = false;
+}
+
+// Create the arrays from the words of the patterns. Every idf depends on
+// the number of patterns, so all values change with any pattern. The
+// values of the patterns are computed on up to threads native threads
+void BagOfPatterns::build(unsigned int threads)
+{
+    vector<pair<uint64_t, uint32_t>> counts(document_counts.begin(), document_counts.end());
+    sort(counts.begin(), counts.end());
+
+    release();
+    own_words.reserve(counts.size());
+    for (const auto& c : counts) {
+        double idf = log(double(pattern_words.size()) / c.second);
+        own_words.push_back(BagWord { c.first, idf, 0, 0, 0 });
+#if DEBUG
+        cerr << int(idf * 1000) << " " << pattern_words.size() << " "
+             << c.second << " " << debugwords[c.first] << endl;
+#endif
+    }
+    // to find the words
+    sync();
+
+    // the values as stored, the square sums and bounds are based on them
+    own_patterns.reserve(pattern_words.size());
+    uint64_t first = 0;
+    for (const auto& pw : pattern_words) {
+        own_patterns.push_back(BagPattern { pw.first, 0, uint32_t(first), uint32_t(pw.second.size()) });
+        first += pw.second.size();
+    }
+    vector<const vector<uint64_t>*> pattern_hashes;
+    pattern_hashes.reserve(pattern_words.size());
+    for (const auto& pw : pattern_words)
+        pattern_hashes.push_back(&pw.second);
+    own_value_words.resize(first);
+    vector<double> stored(first);
+    parallel_for(own_patterns.size(), threads, [&](size_t i) {
+        BagPattern& p = own_patterns[i];
+        const vector<uint64_t>& hashes = *pattern_hashes[i];
+        double square_sum = 0;
+        for (uint32_t w = 0; w < p.count; ++w) {
+            const BagWord* word = find_word(hashes[w]);
+            // every word is only counted once per pattern
+            double value = word->idf;
+            if (use_float)
+                value = float(value);
+            square_sum += value * value;
+            own_value_words[p.first + w] = word - words;
+            stored[p.first + w] = value;
+        }
+        p.square_sum = sqrt(square_sum);
+    });
+    if (use_float)
+        own_float_values.assign(stored.begin(), stored.end());
+    else
+        own_values.swap(stored);
+
+    vector<uint32_t> order;
+    for (size_t i = 0; i < own_patterns.size(); ++i) {
+        // compare2 is not a number for these, they never match
+        if (own_patterns[i].square_sum != 0)
+            order.push_back(i);
+    }
+    stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return own_patterns[a].square_sum < own_patterns[b].square_sum;
+    });
+    for (uint32_t i : order) {
+        const BagPattern& p = own_patterns[i];
+        for (uint32_t v = p.first; v < p.first + p.count; ++v) {
+            BagWord& word = own_words[own_value_words[v]];
+            double value = use_float ? own_float_values[v] : own_values[v];
+            if (!word.posting_count || value > word.max_value)
+                word.max_value = value;
+            word.posting_count++;
+        }
+    }
+    uint32_t first_posting = 0;
+    for (auto& word : own_words) {
+        word.first_posting = first_posting;
+        first_posting += word.posting_count;
+        word.posting_count = 0;
+    }
+    own_postings.resize(first_posting);
+    for (uint32_t i : order) {
+        const BagPattern& p = own_patterns[i];
+        for (uint32_t v = p.first; v < p.first + p.count; ++v) {
+            BagWord& word = own_words[own_value_words[v]];
+            own_postings[word.first_posting + word.posting_count++] = i;
+        }
+    }
+    sync();
+}
 
-    for (TokenList::const_iterator it = t.begin(); it != t.end(); ++it) {
+// The hashes of the words in str, sorted and only once each
+void BagOfPatterns::tokenize(const char* str, vector<uint64_t>& hashes) const
+{
+    TokenList t;
 #if DEBUG
-        debugwords[it->hash] = it->text;
+    TokenTexts texts;
+    Matcher::tokenize(t, str, strlen(str), 1, &texts);
+    for (size_t i = 0; i < t.size(); ++i)
+        debugwords[t[i].hash] = texts[i];
+#else
+    Matcher::tokenize(t, str, strlen(str), 1);
 #endif
-        // only count a word once per document
-        localwords[it->hash] = 1;
+
+    hashes.clear();
+    hashes.reserve(t.size());
+    for (TokenList::const_iterator it = t.begin(); it != t.end(); ++it)
+        hashes.push_back(it->hash);
+    // only count a word once per document
+    sort(hashes.begin(), hashes.end());
+    hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+}
+
+const BagWord* BagOfPatterns::find_word(uint64_t hash) const
+{
+    size_t mask = word_slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const BagWordSlot& slot = word_slots[i];
+        if (!slot.word)
+            return 0;
+        if (slot.hash == hash)
+            return words + slot.word - 1;
     }
 }
 
-double BagOfPatterns::tf_idf(const wordmap& words, vector<TfIdf>& tf_idfs)
+double BagOfPatterns::tf_idf(const vector<uint64_t>& hashes, BagQuery& query) const
 {
     double square_sum = 0;
-    for (wordmap::const_iterator it = words.begin(); it != words.end(); ++it) {
-        double value = it->second * idfs[it->first];
+    for (uint64_t hash : hashes) {
+        // words of no pattern count nothing
+        const BagWord* word = find_word(hash);
+        if (!word)
+            continue;
+        double value = word->idf;
         square_sum += value * value;
-        tf_idfs.emplace_back(it->first, value);
+        query.words.push_back(word - words);
+        query.values.push_back(value);
     }
-    sort(tf_idfs.begin(), tf_idfs.end());
     return sqrt(square_sum);
 }
 
-double BagOfPatterns::compare2(const vector<TfIdf>& tf_idfs1, const Pattern& pattern) const
+template <typename T>
+static double dot_product(const uint32_t* words1, const T* values1, size_t count1, const BagQuery& query)
 {
-    // both vectors are assumed to be sorted by hash
+    // both are sorted by word - step through them without branching
+    // on which one is behind, the CPU can't predict that anyway
     double sum = 0;
-    vector<TfIdf>::const_iterator it1 = pattern.tf_idfs.begin();
-    vector<TfIdf>::const_iterator it2 = tf_idfs1.begin();
-    while (it1 != pattern.tf_idfs.end() && it2 != tf_idfs1.end()) {
-        if (it1->hash == it2->hash) {
-            sum += it1->value * it2->value;
-            ++it1;
-            ++it2;
-        } else if (it1->hash > it2->hash) {
-            ++it2;
-        } else {
-            ++it1;
-        }
+    const uint32_t* words2 = query.words.data();
+    const double* values2 = query.values.data();
+    size_t count2 = query.words.size();
+    size_t i = 0, j = 0;
+    while (i < count1 && j < count2) {
+        uint32_t a = words1[i];
+        uint32_t b = words2[j];
+        if (a == b)
+            sum += values1[i] * values2[j];
+        i += a <= b;
+        j += b <= a;
     }
+    return sum;
+}
+
+double BagOfPatterns::compare2(const BagQuery& query, const BagPattern& pattern) const
+{
+    double sum;
+    if (float_values)
+        sum = dot_product(value_words + pattern.first, float_values + pattern.first, pattern.count, query);
+    else
+        sum = dot_product(value_words + pattern.first, values + pattern.first, pattern.count, query);
     return sum / pattern.square_sum;
 }
 
 AV* BagOfPatterns::best_for(const string& snippet, unsigned int count)
 {
-    AV* result = newAV();
+    update();
+    vector<BagHit> hits;
+    double square_sum = best_hits(snippet, count, hits);
+    return hits_to_av(hits, square_sum);
+}
 
-    wordmap localwords;
-    tokenize(snippet.c_str(), localwords);
+AV* BagOfPatterns::best_for_many(AV* snippets, unsigned int count, unsigned int threads)
+{
+    // before the threads start - it's the only write
+    update();
+
+    // copy the snippets out of perl - the workers must not touch the interpreter
+    vector<string> texts;
+    SSize_t len = av_top_index(snippets) + 1;
+    texts.reserve(len);
+    for (SSize_t i = 0; i < len; ++i) {
+        SV** sv = av_fetch(snippets, i, 0);
+        texts.push_back(sv ? SvPV_nolen(*sv) : "");
+    }
 
-    double highscore = -1;
+    vector<vector<BagHit>> hits(texts.size());
+    vector<double> square_sums(texts.size());
+    parallel_for(texts.size(), threads, [&](size_t i) {
+        square_sums[i] = best_hits(texts[i], count, hits[i]);
+    });
+
+    AV* ret = newAV();
+    av_extend(ret, texts.size());
+    for (size_t i = 0; i < texts.size(); ++i)
+        av_push(ret, newRV_noinc((SV*)hits_to_av(hits[i], square_sums[i])));
+    return ret;
+}
 
-    vector<TfIdf> tfidf;
-    double square_sum = tf_idf(localwords, tfidf);
+// The best count hits for the snippet, best first. Returns the square
+// sum of the snippet the matches are relative to
+double BagOfPatterns::best_hits(const string& snippet, unsigned int count, vector<BagHit>& hits) const
+{
+    if (!count)
+        return 0;
+
+    vector<uint64_t> hashes;
+    tokenize(snippet.c_str(), hashes);
+
+    BagQuery query;
+    double square_sum = tf_idf(hashes, query);
+
+    // Only patterns sharing a word with the snippet can score above 0.
+    // A word has the same value in snippet and pattern, so the sum for
+    // a pattern is at most its square sum squared - and at most the sum
+    // of the words still to look at squared. Divided by the square sum
+    // that limits the patterns that can still beat the last of the hits
+    // to a range of square sums, the rarer words are looked at first to
+    // shrink it quickly (MaxScore)
+    struct Word {
+        double bound;
+        const BagWord* word;
+    };
+    vector<Word> shared;
+    for (size_t i = 0; i < query.words.size(); ++i) {
+        const BagWord* word = words + query.words[i];
+        if (word->posting_count)
+            shared.push_back({ query.values[i] * word->max_value, word });
+    }
+    sort(shared.begin(), shared.end(), [](const Word& a, const Word& b) {
+        return a.bound > b.bound;
+    });
+    vector<double> left(shared.size() + 1, 0);
+    for (size_t i = shared.size(); i-- > 0;)
+        left[i] = left[i + 1] + shared[i].bound;
+
+    // higher match first, on the same match the lower ID
+    auto better = [](const BagHit& a, const BagHit& b) {
+        return a.match > b.match || (a.match == b.match && a.pattern < b.pattern);
+    };
+    // the best count hits so far, the worst of them on top of the heap
+    auto offer = [&](const BagHit& hit) {
+        if (hits.size() == count) {
+            if (!better(hit, hits.front()))
+                return;
+            pop_heap(hits.begin(), hits.end(), better);
+            hits.pop_back();
+        }
+        hits.push_back(hit);
+        push_heap(hits.begin(), hits.end(), better);
+    };
 
-    struct BagHit {
-        BagHit() {} // not used
-        BagHit(double _match, uint64_t _index)
-        {
-            match = _match;
-            index = _index;
+    // leave some room for the rounding of the bounds - and for float
+    // weights, which are not exactly the value in the snippet
+    const double slack = 1 + 1e-6;
+    vector<bool> seen(pattern_count);
+    for (size_t i = 0; i < shared.size(); ++i) {
+        double threshold = hits.size() == count ? hits.front().match : 0;
+        if (left[i] * slack < threshold * threshold)
+            break;
+        const uint32_t* it = postings + shared[i].word->first_posting;
+        const uint32_t* end = it + shared[i].word->posting_count;
+        if (threshold > 0) {
+            it = lower_bound(it, end, threshold, [this, slack](uint32_t p, double t) {
+                return patterns[p].square_sum * slack < t;
+            });
         }
-        bool operator<(const BagHit& rhs)
-        {
-            return match < rhs.match;
+        for (; it != end; ++it) {
+            const BagPattern& pattern = patterns[*it];
+            if (left[i] * slack < pattern.square_sum * threshold)
+                break;
+            if (seen[*it])
+                continue;
+            seen[*it] = true;
+            offer({ compare2(query, pattern), *it });
+            if (hits.size() == count)
+                threshold = hits.front().match;
         }
-        double match;
-        uint64_t index;
-    };
-    vector<BagHit> hits;
-    vector<Pattern>::const_iterator it = patterns.begin();
-    for (; it != patterns.end(); ++it) {
-        double match = compare2(tfidf, *it);
-        if (match > highscore) {
-            hits.emplace_back(match, it->index);
-            sort(hits.rbegin(), hits.rend());
-            if (hits.size() > count) {
-                hits.resize(count);
-                highscore = hits.back().match;
-            }
+    }
+    // fill up with patterns not sharing a word
+    if (hits.size() < count || hits.front().match <= 0) {
+        for (size_t p = 0; p < pattern_count; ++p) {
+            if (hits.size() == count && !better({ 0, uint32_t(p) }, hits.front()))
+                break;
+            if (!seen[p] && patterns[p].square_sum != 0)
+                offer({ 0, uint32_t(p) });
         }
     }
+
+    sort_heap(hits.begin(), hits.end(), better);
+    return square_sum;
+}
+
+AV* BagOfPatterns::hits_to_av(const vector<BagHit>& hits, double square_sum) const
+{
+    AV* result = newAV();
     for (const auto& i : hits) {
         HV* hv = (HV*)sv_2mortal((SV*)newHV());
-        hv_store(hv, "pattern", 7, newSVuv(i.index), 0);
+        hv_store(hv, "pattern", 7, newSVuv(patterns[i.pattern].index), 0);
         hv_store(hv, "match", 5, newSVnv(int(i.match * 10000 / square_sum) / 10000.), 0);
         av_push(result, newRV_inc((SV*)hv));
     }
@@ -244,102 +700,152 @@ AV* BagOfPatterns::best_for(const string& snippet, unsigned int count)
     return result;
 }
 
-void BagOfPatterns::dump(const char* filename) const
-{
-    FILE* file = fopen(filename, "wb");
+// The dump is the header followed by the word, pattern, value, value word
+// and posting arrays as they are in memory (so in host byte order). Loading
+// maps the file and uses the arrays in place once the checksum is fine.
+static const char BAG_DUMP_MAGIC[8] = { 'S', 'P', 'K', 'Y', 'B', 'A', 'G', 'S' };
+static const uint32_t BAG_DUMP_VERSION = 2;
+// the values are float_values
+static const uint32_t BAG_DUMP_FLOAT = 1;
+static const uint64_t BAG_DUMP_SEED = 0x5350;
+
+struct BagDumpHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t word_count;
+    uint32_t pattern_count;
+    uint32_t flags;
+    uint64_t value_count;
+    uint64_t posting_count;
+    // SpookyHash of everything after the header
+    uint64_t checksum;
+};
 
-    uint64_t count = idfs.size();
-    fwrite(&count, sizeof(count), 1, file);
+static_assert(sizeof(BagDumpHeader) % 8 == 0, "keep the arrays aligned");
 
-    map<uint64_t, double>::const_iterator it = idfs.begin();
-    for (; it != idfs.end(); ++it) {
-        uint64_t f1 = it->first;
-        double f2 = it->second;
-        fwrite(&f1, sizeof(f1), 1, file);
-        fwrite(&f2, sizeof(f2), 1, file);
+void BagOfPatterns::dump(const char* filename)
+{
+    update();
+
+    // written next to the file and renamed over it - whoever has the
+    // old one loaded keeps its pages, including this bag
+    string tmpname = string(filename) + "." + to_string(getpid()) + ".tmp";
+    FILE* file = fopen(tmpname.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open " << tmpname << std::endl;
+        return;
     }
 
-    count = patterns.size();
-    fwrite(&count, sizeof(count), 1, file);
-
-    for (const auto& i : patterns) {
-        uint64_t f1 = i.index;
-        fwrite(&f1, sizeof(f1), 1, file);
-        double f2 = i.square_sum;
-        fwrite(&f2, sizeof(f2), 1, file);
-
-        count = i.tf_idfs.size();
-        fwrite(&count, sizeof(count), 1, file);
-        for (const auto& t : i.tf_idfs) {
-            uint64_t f1 = t.hash;
-            double f2 = t.value;
-            fwrite(&f1, sizeof(f1), 1, file);
-            fwrite(&f2, sizeof(f2), 1, file);
-        }
+    const struct {
+        const void* data;
+        size_t size;
+    } arrays[] = {
+        { words, word_count * sizeof(BagWord) },
+        { patterns, pattern_count * sizeof(BagPattern) },
+        { float_values ? (const void*)float_values : values, value_count * (float_values ? sizeof(float) : sizeof(double)) },
+        { value_words, value_count * sizeof(uint32_t) },
+        { postings, posting_count * sizeof(uint32_t) },
+    };
+
+    BagDumpHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BAG_DUMP_MAGIC, sizeof(header.magic));
+    header.version = BAG_DUMP_VERSION;
+    header.word_count = word_count;
+    header.pattern_count = pattern_count;
+    header.flags = float_values ? BAG_DUMP_FLOAT : 0;
+    header.value_count = value_count;
+    header.posting_count = posting_count;
+    // the same as SpookyHash::Hash64 over the arrays in one piece
+    SpookyHash spooky;
+    spooky.Init(BAG_DUMP_SEED, BAG_DUMP_SEED);
+    for (const auto& a : arrays)
+        spooky.Update(a.data, a.size);
+    uint64 h1, h2;
+    spooky.Final(&h1, &h2);
+    header.checksum = h1;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const auto& a : arrays)
+        ok = ok && (!a.size || fwrite(a.data, a.size, 1, file) == 1);
+    if (fclose(file) || !ok || rename(tmpname.c_str(), filename)) {
+        std::cerr << "Failed to write " << filename << std::endl;
+        unlink(tmpname.c_str());
     }
 }
 
 bool BagOfPatterns::load(const char* filename)
 {
-    FILE* file = fopen(filename, "rb");
-    if (!file)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Couldn't open %s\n", filename);
         return false;
-
-    uint64_t count = 0;
-    if (fread(&count, sizeof(count), 1, file) != 1) {
-        fclose(file);
+    }
+    struct stat attr;
+    if (fstat(fd, &attr) == -1) {
+        fprintf(stderr, "Error accessing %s\n", filename);
+        close(fd);
         return false;
     }
-
-    idfs.clear();
-    while (count--) {
-        uint64_t f1 = 0;
-        double f2 = 0;
-        int read = fread(&f1, sizeof(f1), 1, file);
-        read += fread(&f2, sizeof(f2), 1, file);
-        if (read != 2) {
-            fclose(file);
-            return false;
-        }
-        idfs[f1] = f2;
+    size_t size = attr.st_size;
+    if (size < sizeof(BagDumpHeader)) {
+        fprintf(stderr, "%s is not a bag dump\n", filename);
+        close(fd);
+        return false;
     }
-
-    patterns.clear();
-    count = 0;
-    if (fread(&count, sizeof(count), 1, file) != 1) {
-        fclose(file);
+    // shared and read only, so all processes loading it use the same pages
+    char* dump = (char*)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (dump == MAP_FAILED) {
+        fprintf(stderr, "Couldn't map %s\n", filename);
         return false;
     }
 
-    while (count--) {
-        Pattern p;
-        uint64_t f1 = 0;
-        int read = fread(&f1, sizeof(f1), 1, file);
-        p.index = f1;
-        double f2 = 0;
-        read += fread(&f2, sizeof(f2), 1, file);
-        p.square_sum = f2;
-
-        uint64_t f3 = 0;
-        read += fread(&f3, sizeof(f3), 1, file);
-
-        if (read != 3) {
-            fclose(file);
-            return false;
-        }
-        while (f3--) {
-            uint64_t f1;
-            double f2;
-            read = fread(&f1, sizeof(f1), 1, file);
-            read += fread(&f2, sizeof(f2), 1, file);
-            if (read != 2) {
-                fclose(file);
-                return false;
-            }
-            p.tf_idfs.emplace_back(f1, f2);
-        }
-        patterns.push_back(p);
+    const BagDumpHeader* header = reinterpret_cast<const BagDumpHeader*>(dump);
+    if (memcmp(header->magic, BAG_DUMP_MAGIC, sizeof(BAG_DUMP_MAGIC)) || header->version != BAG_DUMP_VERSION) {
+        fprintf(stderr, "%s is not a bag dump of version %d - recreate it\n", filename, BAG_DUMP_VERSION);
+        munmap(dump, size);
+        return false;
+    }
+    const char* p = dump + sizeof(BagDumpHeader);
+    uint64_t expected = sizeof(BagDumpHeader)
+        + uint64_t(header->word_count) * sizeof(BagWord)
+        + uint64_t(header->pattern_count) * sizeof(BagPattern)
+        + header->value_count * ((header->flags & BAG_DUMP_FLOAT ? sizeof(float) : sizeof(double)) + sizeof(uint32_t))
+        + header->posting_count * sizeof(uint32_t);
+    if (header->value_count > UINT32_MAX || header->posting_count > UINT32_MAX
+        || expected != size || SpookyHash::Hash64(p, size - sizeof(BagDumpHeader), BAG_DUMP_SEED) != header->checksum) {
+        fprintf(stderr, "%s is truncated or corrupt\n", filename);
+        munmap(dump, size);
+        return false;
     }
 
+    release();
+    map<uint64_t, vector<uint64_t>>().swap(pattern_words);
+    unordered_map<uint64_t, uint32_t>().swap(document_counts);
+    editable = false;
+    dirty = false;
+    use_float = header->flags & BAG_DUMP_FLOAT;
+    mapping = dump;
+    mapping_length = size;
+    words = reinterpret_cast<const BagWord*>(p);
+    word_count = header->word_count;
+    p += word_count * sizeof(BagWord);
+    patterns = reinterpret_cast<const BagPattern*>(p);
+    pattern_count = header->pattern_count;
+    p += pattern_count * sizeof(BagPattern);
+    value_count = header->value_count;
+    if (header->flags & BAG_DUMP_FLOAT) {
+        float_values = reinterpret_cast<const float*>(p);
+        p += value_count * sizeof(float);
+    } else {
+        values = reinterpret_cast<const double*>(p);
+        p += value_count * sizeof(double);
+    }
+    value_words = reinterpret_cast<const uint32_t*>(p);
+    p += value_count * sizeof(uint32_t);
+    postings = reinterpret_cast<const uint32_t*>(p);
+    posting_count = header->posting_count;
+    index_words();
     return true;
 }
@@ -0,0 +1,65 @@
+#! /usr/bin/perl
+#
+# Latency of changing one pattern of a BagOfPatterns against building it
+# again with set_patterns. The patterns are random runs of words of the
+# t/04license corpus. add_pattern and remove_pattern only note the change,
+# the bag is brought up to date by the next best_for - so that is part of
+# the time. The first change of a loaded bag also gets the words of all
+# patterns back from the dump.
+#
+#   perl -Mblib bench/bag_update.pl [patterns] [changes]
+
+use 5.012;
+use warnings;
+use File::Temp 'tempfile';
+use Spooky::Patterns::XS;
+use Time::HiRes 'time';
+
+my $size    = shift // 20000;
+my $changes = shift // 20;
+
+my @words;
+for my $fn ( glob("t/04license.*.pattern") ) {
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    push( @words, split( /\W+/, join( '', <$fh> ) ) );
+}
+@words = grep { length } @words;
+
+srand(42);
+sub text {
+    my $start = int( rand(@words) );
+    my $len   = 5 + int( rand(150) );
+    return join( ' ', map { $words[ ( $start + $_ ) % @words ] } 1 .. $len );
+}
+my %patterns = map { $_ => text() } 1 .. $size;
+my $snippet  = text();
+
+my $bag = Spooky::Patterns::XS::init_bag_of_patterns;
+my $t0  = time;
+$bag->set_patterns( \%patterns );
+$bag->best_for( $snippet, 1 );
+printf "set_patterns %d patterns: %.3fs\n", $size, time - $t0;
+
+$t0 = time;
+for my $i ( 1 .. $changes ) {
+    $bag->add_pattern( $size + $i, text() );
+    $bag->best_for( $snippet, 1 );
+}
+printf "add_pattern: %.3fs\n", ( time - $t0 ) / $changes;
+
+$t0 = time;
+for my $i ( 1 .. $changes ) {
+    $bag->remove_pattern($i);
+    $bag->best_for( $snippet, 1 );
+}
+printf "remove_pattern: %.3fs\n", ( time - $t0 ) / $changes;
+
+my ( $fh, $dump ) = tempfile();
+$bag->dump($dump);
+$bag = Spooky::Patterns::XS::init_bag_of_patterns;
+$bag->load($dump);
+$t0 = time;
+$bag->add_pattern( 1, text() );
+$bag->best_for( $snippet, 1 );
+printf "first add_pattern on a loaded bag: %.3fs\n", time - $t0;
+unlink($dump);
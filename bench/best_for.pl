@@ -0,0 +1,59 @@
+#! /usr/bin/perl
+#
+# BagOfPatterns::best_for on bags of 10k and 50k patterns. The patterns
+# are random runs of words of the t/04license corpus, the snippets are
+# patterns with a few words replaced, so every snippet has one close
+# pattern and many sharing some words. Reports the time per snippet for
+# every bag size and count, one by one and with best_for_many. The bags
+# are set up on the same number of threads as best_for_many uses.
+#
+#   perl -Mblib bench/best_for.pl [snippets] [sizes] [counts] [threads]
+
+use 5.012;
+use warnings;
+use Spooky::Patterns::XS;
+use Time::HiRes 'time';
+
+my $snippets = shift // 200;
+my @sizes    = split( /,/, shift // '10000,50000' );
+my @counts   = split( /,/, shift // '1,10,100' );
+my $threads  = shift // 4;
+
+my @words;
+for my $fn ( glob("t/04license.*.pattern") ) {
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    push( @words, split( /\W+/, join( '', <$fh> ) ) );
+}
+@words = grep { length } @words;
+
+srand(42);
+for my $size (@sizes) {
+    my %patterns;
+    for my $id ( 1 .. $size ) {
+        my $start = int( rand(@words) );
+        my $len   = 5 + int( rand(150) );
+        $patterns{$id} = join( ' ', map { $words[ ( $start + $_ ) % @words ] } 1 .. $len );
+    }
+    my @texts;
+    for ( 1 .. $snippets ) {
+        my @w = split( / /, $patterns{ 1 + int( rand($size) ) } );
+        $w[ rand(@w) ] = "changed$_" for 1 .. 3;
+        push( @texts, join( ' ', @w ) );
+    }
+
+    my $bag = Spooky::Patterns::XS::init_bag_of_patterns;
+    my $t0  = time;
+    $bag->set_patterns( \%patterns, threads => $threads );
+    printf "%d patterns: set_patterns %.3fs on %d threads\n", $size, time - $t0, $threads;
+    # the first bigger allocation after set_patterns has malloc sort out
+    # the freed temporaries, keep that out of the numbers
+    $bag->best_for( $texts[0], 1 );
+    for my $count (@counts) {
+        $t0 = time;
+        $bag->best_for( $_, $count ) for @texts;
+        printf "  count %3d: %.3fms per snippet", $count, ( time - $t0 ) * 1000 / @texts;
+        $t0 = time;
+        $bag->best_for_many( \@texts, $count, threads => $threads );
+        printf ", %.3fms on %d threads\n", ( time - $t0 ) * 1000 / @texts, $threads;
+    }
+}
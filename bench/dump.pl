@@ -0,0 +1,85 @@
+#! /usr/bin/perl
+#
+# Time and peak memory of Matcher::dump and load for a pattern database
+# of real size. The patterns are the test patterns and random runs of
+# words of the t/04license corpus, like bench/find_matches.pl. The peak
+# is the most resident memory of the process while dumping, above what
+# it used before - reset through /proc/self/clear_refs where possible.
+# A dump with patterns added after a load merges them into the trie
+# first, that's reported as well.
+#
+#   perl -Mblib bench/dump.pl [random patterns] [added patterns]
+
+use 5.012;
+use warnings;
+use File::Temp 'tempfile';
+use Spooky::Patterns::XS;
+use Time::HiRes 'time';
+
+my $patterns = shift // 50000;
+my $added    = shift // 1000;
+
+sub memory {
+    my %status;
+    open( my $fh, '<', '/proc/self/status' ) or return {};
+    while (<$fh>) {
+        $status{$1} = $2 / 1024 if m/^(Vm\w+):\s+(\d+) kB/;
+    }
+    return \%status;
+}
+
+sub reset_peak {
+    open( my $fh, '>', '/proc/self/clear_refs' ) or return;
+    print $fh "5\n";
+}
+
+# run code, report its time and the memory it needed on top
+sub measure {
+    my ( $what, $code ) = @_;
+    reset_peak();
+    my $before = memory()->{VmRSS} // 0;
+    my $t0     = time;
+    $code->();
+    my $took = time - $t0;
+    my $peak = memory()->{VmHWM} // 0;
+    printf "%s: %.3fs, peak %.1fMB above %.1fMB\n", $what, $took,
+        $peak - $before, $before;
+}
+
+my $corpus = '';
+for my $fn ( glob("t/04license.*.txt") ) {
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    $corpus .= join( '', <$fh> );
+}
+srand(42);
+my @words = map { $_->[1] } @{ Spooky::Patterns::XS::normalize($corpus) };
+sub pattern {
+    my $id    = shift;
+    my $len   = 3 + int( rand(20) );
+    my $start = int( rand( @words - $len ) );
+    my @p     = @words[ $start .. $start + $len - 1 ];
+    $p[-1] = "nomatch$id";
+    return Spooky::Patterns::XS::parse_tokens("@p");
+}
+
+my $m = Spooky::Patterns::XS::init_matcher();
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    $m->add_pattern( $1, Spooky::Patterns::XS::parse_tokens( join( '', <$fh> ) ) );
+}
+my @random = map { pattern($_) } 1000 .. 1000 + $patterns - 1;
+measure( "add_pattern $patterns patterns",
+    sub { $m->add_pattern( 1000 + $_, $random[$_] ) for 0 .. $#random } );
+
+my ( $fh, $dump ) = tempfile();
+measure( "dump", sub { $m->dump($dump) } );
+printf "dump size: %.1fMB\n", ( -s $dump ) / 1024 / 1024;
+
+$m = Spooky::Patterns::XS::init_matcher();
+measure( "load", sub { $m->load($dump) } );
+
+my $next = 1000 + $patterns;
+$m->add_pattern( $next + $_, pattern( $next + $_ ) ) for 0 .. $added - 1;
+measure( "dump with $added patterns added", sub { $m->dump($dump) } );
+unlink($dump);
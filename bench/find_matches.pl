@@ -0,0 +1,62 @@
+#! /usr/bin/perl
+#
+# Scan the t/04license corpus scaled up and report tokens per second.
+# To get a trie the size of a real pattern database, random patterns
+# made of words of the corpus are added to the test patterns. The file
+# is scanned `files` times in one find_matches_batch call.
+#
+#   perl -Mblib bench/find_matches.pl [copies] [random patterns] [files] [threads] [engine]
+
+use 5.012;
+use warnings;
+use File::Temp 'tempfile';
+use Spooky::Patterns::XS;
+use Time::HiRes 'time';
+
+my $copies   = shift // 5;
+my $patterns = shift // 20000;
+my $files    = shift // 100;
+my $threads  = shift // 1;
+my $engine   = shift // 'trie';
+
+my $m = Spooky::Patterns::XS::init_matcher();
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    $m->add_pattern( $1, Spooky::Patterns::XS::parse_tokens( join( '', <$fh> ) ) );
+}
+
+my $corpus = '';
+for my $fn ( glob("t/04license.*.txt") ) {
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    $corpus .= join( '', <$fh> );
+}
+
+srand(42);
+my @words = map { $_->[1] } @{ Spooky::Patterns::XS::normalize($corpus) };
+for my $id ( 1000 .. 1000 + $patterns - 1 ) {
+    my $len = 3 + int( rand(20) );
+    my $start = int( rand( @words - $len ) );
+    # real phrases that go wrong at the end, so the scan has to walk
+    # deep into the trie but finds no additional matches
+    my @p = @words[ $start .. $start + $len - 1 ];
+    $p[-1] = "nomatch$id";
+    $m->add_pattern( $id, Spooky::Patterns::XS::parse_tokens("@p") );
+}
+my ( $out, $filename ) = tempfile( UNLINK => 1 );
+print $out $corpus x $copies;
+close($out);
+
+my $tokens = @{ Spooky::Patterns::XS::normalize($corpus) } * $copies;
+
+$m->find_matches( $filename, engine => $engine );    # warm up
+
+my $start = time;
+$m->find_matches_batch(
+    [ ($filename) x $files ],
+    threads => $threads,
+    engine  => $engine
+);
+my $took = time - $start;
+printf( "%d tokens in %.3fs: %.0f tokens/s\n",
+    $tokens * $files, $took, $tokens * $files / $took );
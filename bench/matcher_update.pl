@@ -0,0 +1,73 @@
+#! /usr/bin/perl
+#
+# Latency of adding a few patterns to a loaded Matcher dump, against
+# building the matcher again from all patterns. The patterns are random
+# runs of words of the t/04license corpus. The added patterns are
+# scanned next to the dump, compact writes the dump with them merged
+# while the matcher is still used.
+#
+#   perl -Mblib bench/matcher_update.pl [patterns] [changes]
+
+use 5.012;
+use warnings;
+use File::Temp 'tempfile';
+use Spooky::Patterns::XS;
+use Time::HiRes 'time';
+
+my $size    = shift // 50000;
+my $changes = shift // 20;
+
+my $corpus = '';
+for my $fn ( glob("t/04license.*.txt") ) {
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    $corpus .= join( '', <$fh> );
+}
+my ( $cfh, $text ) = tempfile( UNLINK => 1 );
+print $cfh $corpus;
+close($cfh);
+
+srand(42);
+my @words = map { $_->[1] } @{ Spooky::Patterns::XS::normalize($corpus) };
+# phrases of the corpus with an end of their own, like bench/find_matches.pl
+sub pattern {
+    my $id    = shift;
+    my $len   = 3 + int( rand(20) );
+    my $start = int( rand( @words - $len ) );
+    my @p     = @words[ $start .. $start + $len - 1 ];
+    $p[-1] = "nomatch$id";
+    return Spooky::Patterns::XS::parse_tokens("@p");
+}
+my %patterns = map { $_ => pattern($_) } 1 .. $size;
+
+my $m  = Spooky::Patterns::XS::init_matcher();
+my $t0 = time;
+$m->add_pattern( $_, $patterns{$_} ) for keys %patterns;
+$m->find_matches($text);
+printf "build %d patterns: %.3fs\n", $size, time - $t0;
+
+my ( $fh, $dump ) = tempfile();
+$t0 = time;
+$m->dump($dump);
+printf "dump: %.3fs\n", time - $t0;
+
+$m = Spooky::Patterns::XS::init_matcher();
+$m->load($dump);
+$t0 = time;
+$m->find_matches($text);
+printf "find_matches on the dump: %.3fs\n", time - $t0;
+
+$t0 = time;
+for my $i ( 1 .. $changes ) {
+    $m->add_pattern( $size + $i, pattern( $size + $i ) );
+    $m->remove_pattern($i);
+    $m->find_matches($text);
+}
+printf "add_pattern and remove_pattern with find_matches: %.3fs\n", ( time - $t0 ) / $changes;
+
+$t0 = time;
+$m->compact($dump);
+$m->find_matches($text);
+printf "find_matches while compacting: %.3fs\n", time - $t0;
+$m->wait_compaction;
+printf "compact: %.3fs\n", time - $t0;
+unlink($dump);
@@ -0,0 +1,40 @@
+#! /usr/bin/perl
+#
+# Worst case for $SKIP patterns: a text of one repeated word and
+# patterns made of that word with several $SKIP segments in between,
+# so every start token can continue on every skip offset.
+#
+#   perl -Mblib bench/skips.pl [tokens] [skip] [segments] [engine]
+
+use 5.012;
+use warnings;
+use File::Temp 'tempfile';
+use Spooky::Patterns::XS;
+use Time::HiRes 'time';
+
+my $tokens   = shift // 2000;
+my $skip     = shift // 20;
+my $segments = shift // 3;
+my $engine   = shift // 'trie';
+
+my $m = Spooky::Patterns::XS::init_matcher();
+# one pattern that never matches at its end and one that does
+my $body = join( ' ', ('word') x $segments ) =~ s/ / \$SKIP$skip /gr;
+$m->add_pattern( 1, Spooky::Patterns::XS::parse_tokens("$body nomatch") );
+$m->add_pattern( 2, Spooky::Patterns::XS::parse_tokens("$body word") );
+
+my ( $fh, $filename ) = tempfile( UNLINK => 1 );
+for my $i ( 1 .. $tokens ) {
+    print $fh $i % 10 ? 'word ' : "word\n";
+}
+close $fh;
+
+my $t0  = time;
+my $res = $m->find_matches( $filename, engine => $engine );
+my $t   = time - $t0;
+printf "%d tokens, \$SKIP%d x %d: %.3fs, %d matches\n", $tokens, $skip,
+  $segments - 1, $t, scalar(@$res);
+if ( $m->can('stats') ) {
+    my $stats = $m->stats;
+    say join( ', ', map { "$_ $stats->{$_}" } sort keys %$stats );
+}
@@ -0,0 +1,31 @@
+#! /usr/bin/perl
+#
+# Tokenizer throughput on the t/04license corpus. The texts are scanned
+# from memory with a matcher that has a single pattern never found, so
+# the time is spent splitting, lower casing and hashing the tokens.
+#
+#   perl -Mblib bench/tokenize.pl [copies] [rounds]
+
+use 5.012;
+use warnings;
+use Spooky::Patterns::XS;
+use Time::HiRes 'time';
+
+my $copies = shift // 20;
+my $rounds = shift // 10;
+
+my $corpus = '';
+for my $fn ( glob("t/04license.*.txt") ) {
+    open( my $fh, '<', $fn ) or die "$fn: $!";
+    $corpus .= join( '', <$fh> );
+}
+$corpus x= $copies;
+
+my $m = Spooky::Patterns::XS::init_matcher();
+$m->add_pattern( 1, Spooky::Patterns::XS::parse_tokens('nomatchtoken') );
+
+my $t0 = time;
+$m->find_matches_in_string($corpus) for 1 .. $rounds;
+my $t     = time - $t0;
+my $bytes = length($corpus) * $rounds;
+printf "%d bytes in %.3fs: %.1f MB/s\n", $bytes, $t, $bytes / $t / 1e6;
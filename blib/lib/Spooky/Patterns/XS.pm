@@ -0,0 +1,176 @@
+# Copyright © 2017 SUSE LLC
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, see <http://www.gnu.org/licenses/>.
+
+package Spooky::Patterns::XS;
+
+use strict;
+use warnings;
+
+require Exporter;
+
+our @ISA       = qw(Exporter);
+our @EXPORT_OK = qw();
+
+our $VERSION = '1.56';
+
+require XSLoader;
+XSLoader::load( 'Spooky::Patterns::XS', $VERSION );
+
+package Spooky::Patterns::XS::Matcher;
+
+use Carp;
+use File::Path 'make_path';
+
+# has to match enum MatchEngine
+my %engines = ( trie => 0, 'aho-corasick' => 1 );
+
+sub _engine {
+    my $opts   = shift;
+    my $engine = $engines{ $opts->{engine} // 'trie' };
+    croak "Unknown engine $opts->{engine}" unless defined $engine;
+    return $engine;
+}
+
+# returns [pattern, first line, last line] for every match in the file.
+# Options:
+#   engine => 'trie' (default) or 'aho-corasick'
+sub find_matches {
+    my ( $self, $filename, %opts ) = @_;
+    return $self->_find_matches( $filename, _engine( \%opts ) );
+}
+
+# find_matches for the content of a scalar (taken as bytes, not copied)
+sub find_matches_in_string {
+    my ( $self, $text, %opts ) = @_;
+    return $self->_find_matches_in_string( $text, _engine( \%opts ) );
+}
+
+# find_matches for what can be read from a file handle (or descriptor)
+# from its current position on, line numbers count from there. Perl
+# buffers are not looked at, so use a handle nothing was read from with
+# perl IO yet
+sub find_matches_in_fd {
+    my ( $self, $fh, %opts ) = @_;
+    my $fd = ref($fh) ? fileno($fh) : $fh;
+    croak "Not a file handle" unless defined $fd && $fd =~ m/^\d+$/;
+    return $self->_find_matches_in_fd( $fd, _engine( \%opts ) );
+}
+
+# find_matches for a list of files, scanned from several native threads.
+# Returns one result array (as find_matches would) per file
+sub find_matches_batch {
+    my ( $self, $filenames, %opts ) = @_;
+    return $self->_find_matches_batch( $filenames, $opts{threads} // 1,
+        _engine( \%opts ) );
+}
+
+# counters of all scans so far:
+#   skip_walks  - walks continued after a $SKIP
+#   skip_pruned - walks not continued as they were done already
+sub stats {
+    my $self = shift;
+    my ( $walks, $pruned ) = @{ $self->_stats };
+    return { skip_walks => $walks, skip_pruned => $pruned };
+}
+
+# Replace the patterns of the matcher with the { id => text } patterns.
+# A dump compiled from the same texts by the same tokenizer version is
+# loaded from the cache directory $dir if there is one, otherwise the
+# patterns are added and the dump is written there for the next time
+# (as a new file that is renamed, so processes reading the cache never
+# see half of it) - it warns if it can't. Returns true if the dump was
+# loaded
+sub load_or_build {
+    my ( $self, $dir, $patterns ) = @_;
+
+    # the same patterns have to give the same dump - if two of them
+    # are the same tokens, the one added last wins
+    my @ids = sort { $a <=> $b } keys %$patterns;
+    my $key = 'tokenizer ' . Spooky::Patterns::XS::tokenizer_version() . "\0";
+    for my $id (@ids) {
+        my $text = $patterns->{$id};
+        $key .= "$id " . length($text) . "\0$text";
+    }
+    my $hash = Spooky::Patterns::XS::init_hash( 0, 0 );
+    $hash->add($key);
+    my $dump = "$dir/patterns-" . $hash->hex . ".dump";
+
+    # an older dump format is not loaded, it's compiled again
+    return 1 if -f $dump && $self->load($dump);
+
+    # the dump has to hold exactly these patterns
+    $self->_clear;
+    for my $id (@ids) {
+        $self->add_pattern( $id,
+            Spooky::Patterns::XS::parse_tokens( $patterns->{$id} ) );
+    }
+    eval { make_path($dir) };
+    carp "Failed to cache the patterns in $dump" unless $self->dump($dump);
+    return 0;
+}
+
+package Spooky::Patterns::XS::BagOfPatterns;
+
+use Carp;
+
+my %weights = ( double => 0, float => 1 );
+
+# Replace the patterns with the { id => text } given. Options:
+#   weights => 'double' (default) or 'float' to store the tf-idf weights
+#              in half the space - matches may differ in the last digit
+#   threads => number of native threads to tokenize and weigh the
+#              patterns with (default 1)
+sub set_patterns {
+    my ( $self, $patterns, %opts ) = @_;
+    my $weights = $weights{ $opts{weights} // 'double' };
+    croak "Unknown weights $opts{weights}" unless defined $weights;
+    return $self->_set_patterns( $patterns, $weights, $opts{threads} // 1 );
+}
+
+# best_for for a list of snippets, scored from several native threads.
+# Returns one best_for result per snippet, in the same order. Options:
+#   threads => number of native threads to use (default 1)
+sub best_for_many {
+    my ( $self, $snippets, $count, %opts ) = @_;
+    return $self->_best_for_many( $snippets, $count, $opts{threads} // 1 );
+}
+
+package Spooky::Patterns::XS::NearestPatterns;
+
+# the count patterns with the smallest edit distance to the normalized
+# tokens as [{ pattern => id, distance => d }], nearest first and the
+# smaller ID first on the same distance. Options:
+#   threads => number of native threads to use (default 1)
+sub nearest {
+    my ( $self, $tokens, $count, %opts ) = @_;
+    return $self->_nearest( $tokens, $count, $opts{threads} // 1 );
+}
+
+package Spooky::Patterns::XS::Hash;
+
+sub hex {
+    my $self = shift;
+    my $hash = $self->hash128;
+    return sprintf( "%016x%016x", $hash->[0], $hash->[1] );
+}
+
+sub hash64 {
+    my $self = shift;
+    return $self->hash128->[0];
+}
+
+1;
+
+# vim: set sw=4 et:
@@ -0,0 +1,160 @@
+// Copyright © 2026 SUSE LLC
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see <http://www.gnu.org/licenses/>.
+
+#include "Levenshtein.h"
+#include "Parallel.h"
+#include "patterns_impl.h"
+#include <EXTERN.h>
+#include <XSUB.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <perl.h>
+
+using namespace std;
+
+// The patterns are normalize results reduced to their hashes - the
+// nearest ones to a text are found by edit distance. Most patterns are
+// nowhere near, so before running the distance a lower bound is
+// checked against the worst distance still in the result: the longer
+// length minus the tokens both have in common (counted as multisets),
+// as every other token needs an edit. This covers the difference in
+// length too.
+class NearestPatterns {
+public:
+    void add_pattern(unsigned int id, AV* tokens);
+    AV* nearest(AV* tokens, unsigned int count, unsigned int threads) const;
+
+private:
+    struct Entry {
+        unsigned int id;
+        vector<uint64_t> hashes;
+        // the same sorted, for the common tokens
+        vector<uint64_t> sorted;
+    };
+
+    vector<Entry> patterns;
+};
+
+NearestPatterns* pattern_init_nearest_patterns() { return new NearestPatterns(); }
+
+void destroy_nearest_patterns(NearestPatterns* n) { delete n; }
+
+void pattern_nearest_add(NearestPatterns* n, unsigned int id, AV* tokens)
+{
+    n->add_pattern(id, tokens);
+}
+
+AV* pattern_nearest(NearestPatterns* n, AV* tokens, int count, int threads)
+{
+    return n->nearest(tokens, count > 0 ? count : 0, threads > 0 ? threads : 1);
+}
+
+void NearestPatterns::add_pattern(unsigned int id, AV* tokens)
+{
+    Entry e;
+    e.id = id;
+    // like distance, the last token is not part of it
+    pattern_unpack_hashes(tokens, av_len(tokens), e.hashes);
+    e.sorted = e.hashes;
+    sort(e.sorted.begin(), e.sorted.end());
+    patterns.push_back(std::move(e));
+}
+
+static size_t common_tokens(const vector<uint64_t>& a, const vector<uint64_t>& b)
+{
+    size_t common = 0;
+    vector<uint64_t>::const_iterator it1 = a.begin();
+    vector<uint64_t>::const_iterator it2 = b.begin();
+    while (it1 != a.end() && it2 != b.end()) {
+        if (*it1 == *it2) {
+            ++common;
+            ++it1;
+            ++it2;
+        } else if (*it1 < *it2) {
+            ++it1;
+        } else {
+            ++it2;
+        }
+    }
+    return common;
+}
+
+AV* NearestPatterns::nearest(AV* tokens, unsigned int count, unsigned int threads) const
+{
+    vector<uint64_t> text;
+    pattern_unpack_hashes(tokens, av_len(tokens), text);
+    vector<uint64_t> sorted = text;
+    sort(sorted.begin(), sorted.end());
+
+    struct Candidate {
+        int bound;
+        size_t index;
+    };
+    vector<Candidate> candidates(patterns.size());
+    parallel_for(patterns.size(), threads, [&](size_t i) {
+        const Entry& e = patterns[i];
+        size_t longer = max(e.hashes.size(), text.size());
+        candidates[i].bound = longer - common_tokens(e.sorted, sorted);
+        candidates[i].index = i;
+    });
+    // the most promising first, so the result fills up with good ones
+    sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.bound < b.bound || (a.bound == b.bound && a.index < b.index);
+    });
+
+    // the best count (distance, id) so far, worst on top of the heap
+    typedef pair<int, unsigned int> Hit;
+    vector<Hit> best;
+    mutex best_mutex;
+    // the distance a pattern has to beat - or tie, the ID decides then
+    atomic<int> limit(count ? INT_MAX : -1);
+    parallel_for(candidates.size(), threads, [&](size_t i) {
+        const Candidate& c = candidates[i];
+        int k = limit;
+        // the candidates are sorted by bound, but other threads
+        // might still lower the limit
+        if (c.bound > k)
+            return;
+        const Entry& e = patterns[c.index];
+        int distance = k == INT_MAX ? levenshtein_distance(e.hashes, text) : levenshtein_within(e.hashes, text, k);
+        if (distance < 0)
+            return;
+
+        lock_guard<mutex> lock(best_mutex);
+        Hit hit(distance, e.id);
+        if (best.size() == count) {
+            if (!(hit < best.front()))
+                return;
+            pop_heap(best.begin(), best.end());
+            best.pop_back();
+        }
+        best.push_back(hit);
+        push_heap(best.begin(), best.end());
+        if (best.size() == count)
+            limit = best.front().first;
+    });
+
+    sort_heap(best.begin(), best.end());
+    AV* result = newAV();
+    for (const auto& hit : best) {
+        HV* hv = newHV();
+        hv_store(hv, "pattern", 7, newSVuv(hit.second), 0);
+        hv_store(hv, "distance", 8, newSViv(hit.first), 0);
+        av_push(result, newRV_noinc((SV*)hv));
+    }
+    return result;
+}
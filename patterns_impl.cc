@@ -15,13 +15,15 @@
 
 #include "patterns_impl.h"
 #include "Matcher.h"
+#include "Levenshtein.h"
+#include "Parallel.h"
 #include "SpookyV2.h"
 #include "TokenTree.h"
 #include <EXTERN.h>
 #include <XSUB.h>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
-#include <list>
 #include <map>
 #include <perl.h>
 #include <sys/mman.h>
@@ -31,76 +33,157 @@
 
 using namespace std;
 
-std::vector<AANode> TokenTree::nodes;
-
 const int MAX_TOKEN_LENGTH = 100;
-const int MAX_LINE_SIZE = 8000;
-
-Matcher* Matcher::_self = 0;
 
 Matcher* pattern_init_matcher()
 {
-    Matcher::self()->init();
-    return Matcher::self();
+    return new Matcher;
 }
 
 void destroy_matcher(Matcher* m)
 {
-    // do nothing, we reuse the self
+    delete m;
 }
 
 Matcher::Matcher()
+    : skip_walks(0)
+    , skip_pruned(0)
 {
-    if (_self) {
-        fprintf(stderr, "Matcher::self already initialized\n");
-    }
-    pattern_tree = new TokenTree;
+    pattern_tree = 0;
+    overlay = 0;
+    compaction_ok = true;
     init();
 }
 
+Matcher::~Matcher()
+{
+    wait_compaction();
+    delete pattern_tree;
+    delete overlay;
+}
+
 void Matcher::init()
 {
-    TokenTree::nodes.clear();
-    pattern_tree->initNull();
-    ignored_tokens.clear();
+    wait_compaction();
+    delete pattern_tree;
+    pattern_tree = new PatternTree;
+    delete overlay;
+    overlay = 0;
+    removed.clear();
+    longest_pattern = 0;
+    longest_reach = 0;
+}
 
-    // typical comment and markup - have to be single tokens!
-    static const char* _ignored_tokens[] = {
-        "dnl", "\\n", "\\r", "rem", "br", "p", "c", "cc", "a",
-        "n", "r", 0
-    };
+bool Matcher::wait_compaction()
+{
+    if (compaction.joinable())
+        compaction.join();
+    return compaction_ok;
+}
 
-    int index = 0;
-    while (_ignored_tokens[index]) {
-        int len = strlen(_ignored_tokens[index]);
-        uint64_t h = SpookyHash::Hash64(_ignored_tokens[index], len, 1);
-        ignored_tokens.insert(h);
-        index++;
+// looked up for every token, so it's a small open addressing table
+// instead of a std::set - 0 marks free slots, no token hashes to it
+struct IgnoredTokens {
+    enum { SLOTS = 64 };
+    uint64_t hashes[SLOTS];
+
+    IgnoredTokens()
+    {
+        std::fill(hashes, hashes + SLOTS, 0);
+        // typical comment and markup - have to be single tokens!
+        static const char* _ignored_tokens[] = {
+            "dnl", "\\n", "\\r", "rem", "br", "p", "c", "cc", "a",
+            "n", "r", 0
+        };
+
+        int index = 0;
+        while (_ignored_tokens[index]) {
+            int len = strlen(_ignored_tokens[index]);
+            uint64_t h = SpookyHash::Hash64(_ignored_tokens[index], len, 1);
+            unsigned int i = h % SLOTS;
+            while (hashes[i] && hashes[i] != h)
+                i = (i + 1) % SLOTS;
+            hashes[i] = h;
+            index++;
+        }
     }
-    longest_pattern = 0;
+
+    bool contains(uint64_t h) const
+    {
+        for (unsigned int i = h % SLOTS; hashes[i]; i = (i + 1) % SLOTS)
+            if (hashes[i] == h)
+                return true;
+        return false;
+    }
+};
+
+// initialized once, then only read (also from find_matches_batch)
+static const IgnoredTokens& ignored_tokens()
+{
+    static const IgnoredTokens ignored;
+    return ignored;
+}
+
+// What the tokenizer needs to know about a byte, looked up instead of
+// calling strchr on the separator lists and isalnum/tolower per byte.
+struct CharClasses {
+    enum {
+        SEPARATOR = 1,
+        ALNUM = 2
+    };
+    uint8_t flags[256];
+    char lower[256];
+
+    CharClasses()
+    {
+        static const char* ignore_seps = " \r\n\t*;,:!#{}()[]|></\\";
+        // these are tokens of their own - but they are never alpha
+        // numeric, so they are ignored as well
+        static const char* single_seps = "?\"\'`'=";
+
+        for (int i = 0; i < 256; ++i) {
+            char c = char(i);
+            lower[i] = c;
+            flags[i] = 0;
+            // snipe out escape sequences (on signed char platforms
+            // this includes everything not ascii)
+            if (c < ' ' || strchr(ignore_seps, c) || strchr(single_seps, c)) {
+                flags[i] = SEPARATOR;
+                continue;
+            }
+            lower[i] = tolower(i);
+            if (isalnum(i))
+                flags[i] = ALNUM;
+        }
+    }
+};
+
+static const CharClasses& char_classes()
+{
+    static const CharClasses classes;
+    return classes;
 }
 
 // check if the token is purely non alpha numeric
-bool Matcher::to_ignore(const char* text, unsigned int len) const
+bool Matcher::to_ignore(const char* text, unsigned int len)
 {
-    if (!len)
-        return true;
-    uint64_t index = 0;
-    while (index < len) {
-        if (isalnum(text[index]))
+    const CharClasses& classes = char_classes();
+    for (unsigned int index = 0; index < len; ++index) {
+        if (classes.flags[(unsigned char)text[index]] & CharClasses::ALNUM)
             return false;
-        index++;
     }
     //cerr << "ignore '" << string(text, len) << endl;
     return true;
 }
 
-bool Matcher::to_ignore(uint64_t t) const
+bool Matcher::to_ignore(uint64_t t)
 {
-    return ignored_tokens.find(t) != ignored_tokens.end();
+    return ignored_tokens().contains(t);
 }
 
-void Matcher::add_token(TokenList& result, const char* start, size_t len, int line) const
+// start is the lower cased text of a token that is not purely non
+// alpha numeric
+void Matcher::add_token(TokenList& result, const char* start, size_t len, int line, TokenTexts* texts)
 {
     // very special cases
     if (len > 1 && start[len - 1] == '.') {
@@ -111,9 +194,6 @@ void Matcher::add_token(TokenList& result, const char* start, size_t len, int li
         len--;
     }
 
-    if (to_ignore(start, len))
-        return;
-
     Token t;
     t.linenumber = line;
     t.hash = 0;
@@ -126,7 +206,6 @@ void Matcher::add_token(TokenList& result, const char* start, size_t len, int li
         if (*endptr || t.hash > MAX_SKIP) // more than just a number
             t.hash = 0;
     }
-    t.text = std::string(start, len);
     if (!t.hash) {
         // hash64 has no collisions on our patterns and is very fast
         // *and* 0-3000 (at least) are "free"
@@ -136,44 +215,56 @@ void Matcher::add_token(TokenList& result, const char* start, size_t len, int li
             return;
     }
     result.push_back(t);
+    if (texts)
+        texts->push_back(std::string(start, len));
 }
 
-void Matcher::tokenize(TokenList& result, char* str, int linenumber)
+int Matcher::tokenize(TokenList& result, const char* str, size_t len, int linenumber, TokenTexts* texts)
 {
-    static const char* ignore_seps = " \r\n\t*;,:!#{}()[]|></\\";
-    static const char* single_seps = "?\"\'`'=";
-
-    const char* start = str;
+    const CharClasses& classes = char_classes();
+    const unsigned char* p = (const unsigned char*)str;
+    const unsigned char* end = p + len;
+    // the text is read only (it might be mapped), so lower case a copy
+    char buffer[MAX_TOKEN_LENGTH];
+    std::string long_token;
+
+    while (p < end) {
+        while (p < end && (classes.flags[*p] & CharClasses::SEPARATOR)) {
+            if (*p == '\n' && linenumber)
+                linenumber++;
+            p++;
+        }
+        const unsigned char* start = p;
+        uint8_t flags = 0;
+        while (p < end && !((flags |= classes.flags[*p]) & CharClasses::SEPARATOR))
+            p++;
+        // purely non alpha numeric tokens are ignored
+        if (!(flags & CharClasses::ALNUM))
+            continue;
 
-    for (; *str; ++str) {
-        // snipe out escape sequences
-        if (*str < ' ')
-            *str = ' ';
-        *str = tolower(*str);
-        bool ignored = (strchr(ignore_seps, *str) != NULL);
-        if (ignored || strchr(single_seps, *str)) {
-            add_token(result, start, str - start, linenumber);
-            //fprintf(stderr, "TO %d:'%s'\n", ignored, str);
-            if (!ignored)
-                add_token(result, str, 1, linenumber);
-            start = str + 1;
+        size_t token_len = p - start;
+        char* lower = buffer;
+        if (token_len > sizeof(buffer)) {
+            long_token.resize(token_len);
+            lower = &long_token[0];
         }
+        for (size_t i = 0; i < token_len; ++i)
+            lower[i] = classes.lower[start[i]];
+        add_token(result, lower, token_len, linenumber, texts);
     }
-    add_token(result, start, str - start, linenumber);
+    return linenumber;
+}
+
+int pattern_tokenizer_version()
+{
+    return Matcher::TOKENIZER_VERSION;
 }
 
 AV* pattern_parse(const char* str)
 {
     TokenList t;
-    char* copy = strdup(str);
-    Matcher* m = Matcher::self();
     AV* ret = newAV();
-    if (!m) {
-        fprintf(stderr, "Need a Matcher - call init_matcher\n");
-        return ret;
-    }
-    m->tokenize(t, copy);
-    free(copy);
+    Matcher::tokenize(t, str, strlen(str));
     av_extend(ret, t.size());
     int index = 0;
     uint64_t last_hash = MAX_SKIP + 1;
@@ -194,27 +285,9 @@ AV* pattern_parse(const char* str)
     return ret;
 }
 
-TokenTree* check_or_insert_skip(TokenTree* current, unsigned char uv)
+void pattern_clear(Matcher* m)
 {
-    SkipList::const_iterator last;
-
-    if (current->skips) {
-        SkipList& sl = *current->skips;
-        last = sl.before_begin();
-
-        SkipList::const_iterator sli = sl.begin();
-        for (; sli != sl.end(); ++sli) {
-            if (sli->first == uv)
-                return sli->second;
-            if (sli->first > uv)
-                break;
-            last = sli;
-        }
-    } else {
-        current->skips = new SkipList;
-        last = current->skips->before_begin();
-    }
-    return current->skips->insert_after(last, std::make_pair(uv, new TokenTree))->second;
+    m->init();
 }
 
 void pattern_add(Matcher* m, unsigned int id, av* tokens)
@@ -225,49 +298,177 @@ void pattern_add(Matcher* m, unsigned int id, av* tokens)
         return;
     }
 
-    TokenTree* current = m->pattern_tree;
+    m->wait_compaction();
+    // a loaded dump stays as it is
+    PatternTree* pt = m->pattern_tree;
+    if (pt->is_mapped()) {
+        if (!m->overlay)
+            m->overlay = new PatternTree;
+        pt = m->overlay;
+    }
+    uint32_t current = PatternTree::ROOT;
+    // text tokens a match can span
+    ssize_t reach = 0;
 
     for (SSize_t i = 0; i < len; ++i) {
         SV* sv = *av_fetch(tokens, i, 0);
         UV uv = SvUV(sv);
 
         if (uv <= MAX_SKIP) {
-            current = check_or_insert_skip(current, uv);
+            current = pt->insert_skip(current, uv);
+            reach += uv;
         } else {
-            TokenTree* next = current->find(uv);
-            if (!next) {
-                next = new TokenTree;
-                current->insert(uv, next);
-            }
-            current = next;
+            current = pt->insert(current, uv);
+            reach++;
         }
     }
-    if (current->pid) {
-        std::cerr << "Problem: ID " << id << " overwrites " << current->pid << std::endl;
+    uint32_t old = pt->set_pid(current, id);
+    if (old && old != id) {
+        std::cerr << "Problem: ID " << id << " overwrites " << old << std::endl;
     }
-    current->pid = id;
     if (len > m->longest_pattern)
         m->longest_pattern = len;
+    if (reach > m->longest_reach)
+        m->longest_reach = reach;
 }
 
-void add_match(const TokenList& ts, Matches& ms, int tokenlist_offset, int tokenlist_index, unsigned int matched, int pid)
+bool pattern_remove(Matcher* m, unsigned int id)
+{
+    m->wait_compaction();
+    bool found = m->overlay && m->overlay->clear_pid(id);
+    if (!m->pattern_tree->is_mapped())
+        return m->pattern_tree->clear_pid(id) || found;
+    if (!m->removed.count(id) && m->pattern_tree->has_pid(id)) {
+        m->removed.insert(id);
+        found = true;
+    }
+    return found;
+}
+
+// The tokens of a text around the scan position, addressed by their
+// position in the text. Only the last tokens are kept in a ring - the
+// scan makes sure a position is evaluated once all tokens a match
+// starting there could reach have been added, and before the ring
+// wraps over the tokens it still looks at.
+class TokenWindow {
+public:
+    explicit TokenWindow(size_t keep)
+    {
+        size_t capacity = 16;
+        while (capacity < keep)
+            capacity *= 2;
+        ring.resize(capacity);
+        mask = capacity - 1;
+        count = 0;
+    }
+
+    const Token& operator[](size_t i) const { return ring[i & mask]; }
+    // all tokens added so far
+    size_t size() const { return count; }
+    void push_back(const Token& t) { ring[count++ & mask] = t; }
+
+private:
+    vector<Token> ring;
+    size_t mask;
+    size_t count;
+};
+
+void add_match(const TokenWindow& ts, Matches& ms, size_t start, size_t matched, int pid)
 {
     Match m;
-    m.start = tokenlist_offset + tokenlist_index;
-    m.matched = matched - tokenlist_index;
+    m.start = start;
+    m.matched = matched - start;
 
-    m.sline = ts[tokenlist_index].linenumber;
+    m.sline = ts[start].linenumber;
     m.eline = ts[matched - 1].linenumber;
 
     m.pattern = pid;
 #if DEBUG
-    fprintf(stderr, "L %d(%d)-%d(%d) id:%d\n", ts[tokenlist_index].linenumber,
-        tokenlist_offset + tokenlist_index, ts[matched - 1].linenumber, m.matched, m.pattern);
+    fprintf(stderr, "L %d(%zu)-%d(%d) id:%d\n", ts[start].linenumber,
+        start, ts[matched - 1].linenumber, m.matched, m.pattern);
 #endif
     ms.push_back(m);
 }
 
-void check_token_matches(const TokenList& tokens, Matches& ms, int tokenlist_offset, int tokenlist_index, unsigned int offset, const TokenTree* patterns)
+// Remembers the $SKIP subtrees the walks from one start token entered
+// and at which offset. What is found from there only depends on that
+// pair - entering it again can only repeat matches, and without this
+// nested $SKIP segments try every combination of offsets. The trees
+// behind a $SKIP edge are only reachable through that edge, so this
+// bounds a walk by skip trees x window.
+// It's reset for every start token, so it's an open addressing table
+// cleared by bumping the generation.
+class SkipMemo {
+public:
+    uint64_t walks; // sub-walks started on a $SKIP edge
+    uint64_t pruned; // sub-walks not started as they were walked before
+
+    SkipMemo()
+        : walks(0)
+        , pruned(0)
+        , generation(1)
+        , used(0)
+        , slots(64)
+    {
+    }
+
+    void reset()
+    {
+        used = 0;
+        if (!++generation) {
+            std::fill(slots.begin(), slots.end(), Slot());
+            generation = 1;
+        }
+    }
+
+    // false if the pair was visited since the last reset - offsets
+    // are less than a pattern apart, so 32 bits of them are enough
+    bool visit(uint32_t tree, size_t offset)
+    {
+        if (2 * (used + 1) > slots.size())
+            grow();
+        return insert((uint64_t(tree) << 32) | uint32_t(offset));
+    }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        uint32_t generation = 0;
+    };
+
+    uint32_t generation;
+    size_t used;
+    vector<Slot> slots;
+
+    bool insert(uint64_t key)
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = (key * 0x9E3779B97F4A7C15ULL) >> 32 & mask;
+        while (slots[i].generation == generation) {
+            if (slots[i].key == key)
+                return false;
+            i = (i + 1) & mask;
+        }
+        slots[i].key = key;
+        slots[i].generation = generation;
+        used++;
+        return true;
+    }
+
+    void grow()
+    {
+        vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        used = 0;
+        for (const Slot& s : old)
+            if (s.generation == generation)
+                insert(s.key);
+    }
+};
+
+static void follow_skips(const PatternTree* pt, const TokenWindow& tokens, Matches& ms, size_t start, size_t offset, const TokenTree* patterns, SkipMemo& memo);
+
+void check_token_matches(const PatternTree* pt, const TokenWindow& tokens, Matches& ms, size_t start, size_t offset, const TokenTree* patterns, SkipMemo& memo)
 {
     if (offset >= tokens.size())
         return;
@@ -276,105 +477,299 @@ void check_token_matches(const TokenList& tokens, Matches& ms, int tokenlist_off
         if (offset >= tokens.size()) {
             // end of text, check if pattern ends too
             if (patterns->pid)
-                add_match(tokens, ms, tokenlist_offset, tokenlist_index, offset, patterns->pid);
+                add_match(tokens, ms, start, offset, patterns->pid);
             return;
         }
 
 #if DEBUG
-        fprintf(stderr, "MP %d %d:%s\n", offset,
-            patterns->find(tokens[offset].hash) ? 1 : 0,
-            tokens[offset].text.c_str());
+        fprintf(stderr, "MP %zu %d:%lx\n", offset,
+            pt->find(patterns, tokens[offset].hash) ? 1 : 0,
+            tokens[offset].hash);
 #endif
 
-        if (patterns->skips) {
-            for (SkipList::const_iterator it = patterns->skips->begin(); it != patterns->skips->end(); ++it) {
-                for (int i = 1; i <= it->first; ++i) {
-                    check_token_matches(tokens, ms, tokenlist_offset, tokenlist_index, offset + i, it->second);
-                }
-            }
-        }
+        if (patterns->skips)
+            follow_skips(pt, tokens, ms, start, offset, patterns, memo);
         if (patterns->pid)
-            add_match(tokens, ms, tokenlist_offset, tokenlist_index, offset, patterns->pid);
-        patterns = patterns->find(tokens[offset].hash);
+            add_match(tokens, ms, start, offset, patterns->pid);
+        patterns = pt->find(patterns, tokens[offset].hash);
         offset++;
     }
 }
 
-// if either the start or the end of one region is within the other
-bool match_overlap(int s1, int e1, int s2, int e2)
+// continue the walk on all $SKIP edges of patterns
+static void follow_skips(const PatternTree* pt, const TokenWindow& tokens, Matches& ms, size_t start, size_t offset, const TokenTree* patterns, SkipMemo& memo)
 {
-    if (s1 >= s2 && s1 <= e2)
-        return true;
-    if (e1 >= s2 && e1 <= e2)
-        return true;
-    return false;
+    for (uint32_t s = patterns->skips; s; s = pt->skips[s].next) {
+        const SkipNode& sn = pt->skips[s];
+        for (size_t i = offset + 1; i <= offset + sn.skip && i < tokens.size(); ++i) {
+            if (!memo.visit(sn.tree, i)) {
+                memo.pruned++;
+                continue;
+            }
+            memo.walks++;
+            check_token_matches(pt, tokens, ms, start, i, pt->trees + sn.tree, memo);
+        }
+    }
 }
 
-void find_tokens(Matcher* m, TokenList& ts, Matches& ms, int tokenlist_offset, int tokenlist_index)
+void find_tokens(const PatternTree* pt, const TokenWindow& ts, Matches& ms, size_t start, SkipMemo& memo)
 {
-    TokenTree* patterns = m->pattern_tree->find(ts[tokenlist_index].hash);
+    const TokenTree* patterns = pt->find(pt->root(), ts[start].hash);
     if (!patterns)
         return;
-    check_token_matches(ts, ms, tokenlist_offset, tokenlist_index, tokenlist_index + 1, patterns);
+    memo.reset();
+    check_token_matches(pt, ts, ms, start, start + 1, patterns, memo);
 }
 
-AV* pattern_find_matches(Matcher* m, const char* filename)
+// Aho-Corasick: feed token j into the automaton and record everything
+// ending there. States with skips continue with check_token_matches,
+// which is where the restart engine would be at this point as well.
+static void feed_token(const PatternTree* pt, const TokenWindow& ts, Matches& ms, size_t j, const TokenTree*& state, SkipMemo& memo)
 {
-    AV* ret = newAV();
+    uint64_t x = ts[j].hash;
+    const TokenTree* next;
+    while (!(next = pt->find(state, x)) && state != pt->root())
+        state = pt->trees + pt->link_of(state).fail;
+    state = next ? next : pt->root();
+
+    size_t offset = j + 1;
+    const TokenTree* s = state;
+    if (s == pt->root() || !(s->pid || s->skips))
+        s = pt->trees + pt->link_of(s).output;
+    for (; s != pt->trees; s = pt->trees + pt->link_of(s).output) {
+        size_t depth = pt->link_of(s).depth;
+        size_t start = offset - depth;
+        if (offset >= ts.size()) {
+            // the restart engine does not look at the state of a single
+            // token at the very end, keep the results comparable
+            if (s->pid && depth > 1)
+                add_match(ts, ms, start, offset, s->pid);
+            continue;
+        }
+        if (s->skips) {
+            memo.reset();
+            follow_skips(pt, ts, ms, start, offset, s, memo);
+        }
+        if (s->pid)
+            add_match(ts, ms, start, offset, s->pid);
+    }
+}
 
-    FILE* input = fopen(filename, "r");
-    if (!input) {
-        std::cerr << "Failed to open " << filename << std::endl;
-        return ret;
+// The content of a file - mapped if it's a regular file and read into
+// memory otherwise (pipes, sockets).
+class FileContent {
+public:
+    const char* data;
+    size_t size;
+
+    FileContent()
+        : data(0)
+        , size(0)
+        , mapping(0)
+        , mapping_size(0)
+    {
     }
 
-    char line[MAX_LINE_SIZE];
-    int linenumber = 1;
-    TokenList ts;
-    Matches ms;
-    int token_offset = 0;
-    while (fgets(line, sizeof(line) - 1, input)) {
-        m->tokenize(ts, line, linenumber++);
-        // preserve memory
-        if (SSize_t(ts.size()) > m->longest_pattern * 100) {
-            unsigned int erasing = ts.size() - m->longest_pattern - 1;
-            for (unsigned int i = 0; i < erasing; i++)
-                find_tokens(m, ts, ms, token_offset, i);
-            ts.erase(ts.begin(), ts.begin() + erasing);
-            token_offset += erasing;
+    ~FileContent()
+    {
+        if (mapping)
+            munmap(mapping, mapping_size);
+    }
+
+    bool open(const char* filename)
+    {
+        int fd = ::open(filename, O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Failed to open " << filename << std::endl;
+            return false;
         }
+        bool ok = read(fd);
+        if (!ok)
+            std::cerr << "Failed to read " << filename << std::endl;
+        close(fd);
+        return ok;
     }
-    fclose(input);
-    for (unsigned int i = 0; i < ts.size(); i++)
-        find_tokens(m, ts, ms, token_offset, i);
 
-    Matches bests;
-    while (ms.size()) {
-        Matches::const_iterator it = ms.begin();
-        Match best = *(it++);
-        for (; it != ms.end(); ++it) {
-            // the bigger IDs win on same matches - we expect newer patterns to be used
-            if (best.matched < it->matched || (best.matched == it->matched && best.pattern < it->pattern)) {
-                best = *it;
+    // the content from the current position of fd on
+    bool read(int fd)
+    {
+        struct stat attr;
+        if (fstat(fd, &attr) == -1)
+            return false;
+        off_t pos = lseek(fd, 0, SEEK_CUR);
+        if (S_ISREG(attr.st_mode) && pos >= 0) {
+            if (pos >= attr.st_size)
+                return true;
+            mapping = mmap(0, attr.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                mapping_size = attr.st_size;
+                madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+                data = (const char*)mapping + pos;
+                size = mapping_size - pos;
+                return true;
             }
+            mapping = 0;
         }
+        char block[1 << 16];
+        ssize_t got;
+        while ((got = ::read(fd, block, sizeof(block))) > 0)
+            buffer.append(block, got);
+        data = buffer.data();
+        size = buffer.size();
+        return got == 0;
+    }
+
+private:
+    void* mapping;
+    size_t mapping_size;
+    std::string buffer;
+
+    // forbidden
+    FileContent(const FileContent&);
+};
+
+// the text is tokenized in chunks of about this size, so only a window
+// of the tokens of a big file is in memory
+const size_t SCAN_CHUNK = 1 << 16;
+
+// The longest match wins, on the same length the bigger ID - we expect
+// newer patterns to be used - and then the one found first. Everything
+// overlapping a winner is out, then the next one wins. That's a sort
+// and one sweep over the candidates, checking each against the winners
+// so far (which don't overlap, so only the one starting before its end
+// can).
+static void select_winners(Matches& ms, Matches& bests)
+{
+    std::stable_sort(ms.begin(), ms.end(), [](const Match& a, const Match& b) {
+        if (a.matched != b.matched)
+            return a.matched > b.matched;
+        return a.pattern > b.pattern;
+    });
+
+    // start -> end of the winners
+    std::map<size_t, size_t> taken;
+    for (const Match& m : ms) {
+        size_t end = m.start + m.matched - 1;
+        auto next = taken.upper_bound(end);
+        if (next != taken.begin() && std::prev(next)->second >= m.start) {
 #if DEBUG
-        std::cerr << filename << "(" << best.pattern << ") " << best.start << ":" << best.matched << std::endl;
+            std::cerr << "( erase " << m.pattern << ") " << m.start << ":" << m.matched << std::endl;
 #endif
-        bests.push_back(best);
-        for (Matches::iterator it2 = ms.begin(); it2 != ms.end();) {
-            if (match_overlap(it2->start, it2->start + it2->matched - 1, best.start, best.start + best.matched - 1)) {
+            continue;
+        }
 #if DEBUG
-                std::cerr << filename << "( erase " << it2->pattern << ") " << it2->start << ":" << it2->matched << std::endl;
+        std::cerr << "(" << m.pattern << ") " << m.start << ":" << m.matched << std::endl;
 #endif
-                it2 = ms.erase(it2);
-            } else
-                it2++;
+        taken.emplace_hint(next, m.start, end);
+        bests.push_back(m);
+    }
+}
+
+// The end of the chunk of text to tokenize next: right after a
+// separator, so no token is split. If there is none in a whole chunk,
+// the token goes on into the next one and is taken in one piece
+static const char* next_chunk_end(const char* text, const char* text_end)
+{
+    if (size_t(text_end - text) <= SCAN_CHUNK)
+        return text_end;
+    const CharClasses& classes = char_classes();
+    const char* end = text + SCAN_CHUNK;
+    while (end > text && !(classes.flags[(unsigned char)end[-1]] & CharClasses::SEPARATOR))
+        end--;
+    if (end > text)
+        return end;
+    end = text + SCAN_CHUNK;
+    while (end < text_end && !(classes.flags[(unsigned char)*end++] & CharClasses::SEPARATOR))
+        ;
+    return end;
+}
+
+static void scan_position(const PatternTree* pt, const TokenWindow& ts, Matches& ms, size_t position, const TokenTree*& state, SkipMemo& memo, MatchEngine engine)
+{
+    if (engine == ENGINE_AHO_CORASICK)
+        feed_token(pt, ts, ms, position, state, memo);
+    else
+        find_tokens(pt, ts, ms, position, memo);
+}
+
+// scan size bytes of text - this only uses the matcher read only and
+// keeps all its state on the stack, so it can run in several threads
+// at once
+static void scan_text(const Matcher* m, const char* text, size_t size, Matches& bests, MatchEngine engine)
+{
+    // the pattern trees to walk - the overlay is scanned on its own, so
+    // every tree has its own Aho-Corasick state and matches
+    struct Scan {
+        const PatternTree* pt;
+        const TokenTree* state;
+        Matches ms;
+    };
+    Scan scans[2];
+    size_t scan_count = 0;
+    scans[scan_count++].pt = m->pattern_tree;
+    if (m->overlay)
+        scans[scan_count++].pt = m->overlay;
+    for (size_t i = 0; i < scan_count; ++i)
+        scans[i].state = scans[i].pt->root();
+
+    const char* text_end = text + size;
+    int linenumber = 1;
+    // a match starting at a position can reach this many tokens further.
+    // The Aho-Corasick engine reports matches ending at the token fed, so
+    // it looks back a pattern length on top
+    size_t reach = m->longest_reach;
+    TokenWindow ts(reach + 1 + m->longest_pattern);
+    TokenList chunk;
+    // the next position to evaluate
+    size_t next = 0;
+    SkipMemo memo;
+    while (text < text_end) {
+        const char* chunk_end = next_chunk_end(text, text_end);
+        chunk.clear();
+        linenumber = m->tokenize(chunk, text, chunk_end - text, linenumber);
+        text = chunk_end;
+        for (const Token& t : chunk) {
+            ts.push_back(t);
+            // all tokens a match starting at next could reach are there
+            if (ts.size() > next + reach) {
+                for (size_t i = 0; i < scan_count; ++i)
+                    scan_position(scans[i].pt, ts, scans[i].ms, next, scans[i].state, memo, engine);
+                next++;
+            }
         }
     }
+    for (; next < ts.size(); next++) {
+        for (size_t i = 0; i < scan_count; ++i)
+            scan_position(scans[i].pt, ts, scans[i].ms, next, scans[i].state, memo, engine);
+    }
+    m->skip_walks += memo.walks;
+    m->skip_pruned += memo.pruned;
+
+    Matches& ms = scans[0].ms;
+    if (!m->removed.empty()) {
+        ms.erase(std::remove_if(ms.begin(), ms.end(), [m](const Match& match) {
+            return m->removed.count(match.pattern) != 0;
+        }),
+            ms.end());
+    }
+    if (scan_count > 1)
+        ms.insert(ms.end(), scans[1].ms.begin(), scans[1].ms.end());
+    select_winners(ms, bests);
+}
 
-    int index = 0;
-    for (Matches::const_iterator it = bests.begin(); it != bests.end(); ++it, ++index) {
+static bool scan_file(const Matcher* m, const char* filename, Matches& bests, MatchEngine engine)
+{
+    FileContent content;
+    if (!content.open(filename))
+        return false;
+    scan_text(m, content.data, content.size, bests, engine);
+    return true;
+}
+
+static AV* matches_to_av(const Matches& bests)
+{
+    AV* ret = newAV();
+    for (Matches::const_iterator it = bests.begin(); it != bests.end(); ++it) {
         AV* line = newAV();
         av_push(line, newSVuv(it->pattern));
         av_push(line, newSVuv(it->sline));
@@ -384,200 +779,320 @@ AV* pattern_find_matches(Matcher* m, const char* filename)
     return ret;
 }
 
-void pattern_dump(Matcher* m, const char* filename)
+// prepare the pattern tree for the engine - this modifies the tree
+// and has to happen before any scan thread starts
+static void prepare_engine(Matcher* m, MatchEngine engine)
 {
-    FILE* file = fopen(filename, "wb");
-    fwrite(&m->longest_pattern, sizeof(m->longest_pattern), 1, file);
+    for (PatternTree* pt : { m->pattern_tree, m->overlay }) {
+        if (!pt)
+            continue;
+        pt->freeze();
+        if (engine == ENGINE_AHO_CORASICK)
+            pt->link();
+    }
+}
 
-    SerializeInfo si;
+AV* pattern_find_matches(Matcher* m, const char* filename, int engine)
+{
+    prepare_engine(m, MatchEngine(engine));
+    Matches bests;
+    scan_file(m, filename, bests, MatchEngine(engine));
+    return matches_to_av(bests);
+}
 
-    m->pattern_tree->mark_elements(si);
-    fwrite(&si.tree_count, sizeof(si.tree_count), 1, file);
-    uint32_t count = TokenTree::nodes.size();
-    fwrite(&count, sizeof(count), 1, file);
+AV* pattern_find_matches_in_string(Matcher* m, SV* text, int engine)
+{
+    prepare_engine(m, MatchEngine(engine));
+    STRLEN len;
+    const char* data = SvPV(text, len);
+    Matches bests;
+    scan_text(m, data, len, bests, MatchEngine(engine));
+    return matches_to_av(bests);
+}
 
-#if 0
-    fwrite(&si.element_count, sizeof(si.element_count), 1, file);
+AV* pattern_find_matches_in_fd(Matcher* m, int fd, int engine)
+{
+    prepare_engine(m, MatchEngine(engine));
+    Matches bests;
+    FileContent content;
+    if (content.read(fd))
+        scan_text(m, content.data, content.size, bests, MatchEngine(engine));
+    else
+        std::cerr << "Failed to read from fd " << fd << std::endl;
+    return matches_to_av(bests);
+}
 
-    // elements are quick
-    uint64_t* elements = new uint64_t[si.element_count];
-    for (std::map<uint64_t, int>::const_iterator it = si.elements.begin(); it != si.elements.end(); it++) {
-        elements[it->second] = it->first;
-    }
-    fwrite(elements, sizeof(uint64_t), si.element_count, file);
-    delete[] elements;
-#endif
+AV* pattern_stats(Matcher* m)
+{
+    AV* ret = newAV();
+    av_push(ret, newSVuv(m->skip_walks));
+    av_push(ret, newSVuv(m->skip_pruned));
+    return ret;
+}
 
-    // trees reference nodes and are recursive
-    const TokenTree** trees = new const TokenTree*[si.tree_count];
-    memset(trees, 0, si.tree_count * sizeof(TokenTree*));
-    for (std::map<const TokenTree*, int>::const_iterator it = si.trees.begin();
-         it != si.trees.end(); it++) {
-        trees[it->second] = it->first;
-    }
-
-    for (int i = 0; i < si.tree_count; i++) {
-        const TokenTree* t = trees[i];
-        fwrite(&t->pid, sizeof(uint32_t), 1, file);
-        char skip_count = 0;
-        if (t->skips) {
-            // forward_list has no length - but is cheap
-            for (SkipList::const_iterator it = t->skips->begin(); it != t->skips->end(); ++it)
-                skip_count++;
-        }
-        fwrite(&skip_count, 1, 1, file);
-        if (t->skips) {
-            for (SkipList::const_iterator it = t->skips->begin(); it != t->skips->end(); ++it) {
-                fwrite(&it->first, 1, 1, file);
-                int32_t index = si.trees[it->second];
-                fwrite(&index, sizeof(int32_t), 1, file);
-            }
-        }
-        int32_t index = t->root;
-        fwrite(&index, sizeof(int32_t), 1, file);
+AV* pattern_find_matches_batch(Matcher* m, AV* filenames, int threads, int engine)
+{
+    // copy the names out of perl - the workers must not touch the interpreter
+    vector<string> names;
+    SSize_t len = av_top_index(filenames) + 1;
+    names.reserve(len);
+    for (SSize_t i = 0; i < len; ++i) {
+        SV** sv = av_fetch(filenames, i, 0);
+        names.push_back(sv ? SvPV_nolen(*sv) : "");
     }
-    delete[] trees;
 
-    vector<AANode>::const_iterator it = TokenTree::nodes.begin();
-    it++; // skip nullNode
-    for (; it != TokenTree::nodes.end(); ++it) {
-        fwrite(&it->element, sizeof(int64_t), 1, file);
-        uint32_t index = it->left;
-        fwrite(&index, sizeof(int32_t), 1, file);
-        index = it->right;
-        fwrite(&index, sizeof(int32_t), 1, file);
-        fwrite(&it->level, sizeof(it->level), 1, file);
-        index = si.trees[it->next_token];
-        fwrite(&index, sizeof(int32_t), 1, file);
-    }
+    // before the threads start - it's the only write
+    prepare_engine(m, MatchEngine(engine));
 
-    uint32_t index = m->pattern_tree->root;
-    fwrite(&index, sizeof(uint32_t), 1, file);
+    vector<Matches> results(names.size());
+    parallel_for(names.size(), threads > 0 ? threads : 1, [&](size_t i) {
+        scan_file(m, names[i].c_str(), results[i], MatchEngine(engine));
+    });
 
-    fclose(file);
+    AV* ret = newAV();
+    av_extend(ret, results.size());
+    for (const auto& r : results)
+        av_push(ret, newRV_noinc((SV*)matches_to_av(r)));
+    return ret;
 }
 
-void pattern_load(Matcher* m, const char* filename)
+// The dump is the header followed by the edge, tree and skip arrays of
+// the frozen PatternTree as they are in memory (so in host byte order).
+// Loading maps the file and uses the arrays in place.
+static const char DUMP_MAGIC[8] = { 'S', 'P', 'K', 'Y', 'T', 'R', 'E', 'E' };
+static const uint32_t DUMP_VERSION = 3;
+
+struct DumpHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tree_count;
+    uint32_t skip_count;
+    uint32_t edge_count;
+    // informational only, load computes them from the arrays
+    int64_t longest_pattern;
+    int64_t longest_reach;
+};
+
+static_assert(sizeof(DumpHeader) % 8 == 0, "keep the edge keys aligned");
+
+// Write the patterns of m as one tree, merging the overlay and the
+// removed patterns into the loaded dump. This only reads the matcher,
+// so it can run next to scans. The dump is written next to the file and
+// renamed over it - whoever has the old one loaded keeps its pages,
+// including m itself
+static bool dump_patterns(const Matcher* m, const string& filename)
 {
-    int fd = open(filename, O_RDONLY);
-    if (fd < 0) {
-        fprintf(stderr, "Couldn't open %s\n", filename);
-        return;
-    }
-    struct stat attr;
-    if (fstat(fd, &attr) == -1) {
-        fprintf(stderr, "Error accessing %s\n", filename);
-        return;
+    string tmpname = filename + "." + std::to_string(getpid()) + ".tmp";
+    FILE* file = fopen(tmpname.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open " << tmpname << std::endl;
+        return false;
     }
-    char* dump = (char*)mmap(NULL, attr.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
 
-    m->longest_pattern = *reinterpret_cast<SSize_t*>(dump);
-    dump += sizeof(SSize_t);
+    const PatternTree* pt = m->pattern_tree;
+    PatternTree merged;
+    if (m->overlay || !m->removed.empty()) {
+        merged.merge(*pt, m->overlay, m->removed);
+        pt = &merged;
+    }
 
-    SerializeInfo si;
+    DumpHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DUMP_MAGIC, sizeof(header.magic));
+    header.version = DUMP_VERSION;
+    header.tree_count = pt->tree_count;
+    header.skip_count = pt->skip_count;
+    header.edge_count = pt->edge_count;
+    header.longest_pattern = m->longest_pattern;
+    header.longest_reach = m->longest_reach;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(pt->edges, sizeof(Edge), pt->edge_count, file) == pt->edge_count;
+    ok = ok && fwrite(pt->trees, sizeof(TokenTree), pt->tree_count, file) == pt->tree_count;
+    ok = ok && fwrite(pt->skips, sizeof(SkipNode), pt->skip_count, file) == pt->skip_count;
+    if (fclose(file) || !ok || rename(tmpname.c_str(), filename.c_str())) {
+        std::cerr << "Failed to write " << filename << std::endl;
+        unlink(tmpname.c_str());
+        return false;
+    }
+    return true;
+}
 
-    si.tree_count = *reinterpret_cast<int32_t*>(dump);
-    dump += sizeof(int32_t);
-    uint32_t node_count = *reinterpret_cast<uint32_t*>(dump);
-    dump += sizeof(int32_t);
+static void freeze_patterns(Matcher* m)
+{
+    m->pattern_tree->freeze();
+    if (m->overlay)
+        m->overlay->freeze();
+}
 
-#if 0
-    si.element_count = *reinterpret_cast<uint32_t*>(dump);
-    dump += sizeof(int32_t);
+bool pattern_dump(Matcher* m, const char* filename)
+{
+    m->wait_compaction();
+    freeze_patterns(m);
+    return dump_patterns(m, filename);
+}
 
-    uint64_t* elements = reinterpret_cast<uint64_t*>(dump);
-    dump += sizeof(uint64_t) * si.element_count;
-#endif
+void pattern_compact(Matcher* m, const char* filename)
+{
+    m->wait_compaction();
+    // the only write, the thread just reads
+    freeze_patterns(m);
+    string name(filename);
+    m->compaction = std::thread([m, name]() {
+        m->compaction_ok = dump_patterns(m, name);
+    });
+}
 
-#if 1
-    TokenTree** trees = new TokenTree*[si.tree_count];
-    for (int i = 0; i < si.tree_count; i++)
-        trees[i] = new TokenTree;
-#endif
+bool pattern_wait_compaction(Matcher* m)
+{
+    return m->wait_compaction();
+}
 
-    for (int i = 0; i < si.tree_count; i++) {
-        TokenTree* t = trees[i];
-        t->pid = *reinterpret_cast<uint32_t*>(dump);
-        dump += sizeof(uint32_t);
-
-        unsigned char skip_count = *reinterpret_cast<unsigned char*>(dump++);
-        if (skip_count) {
-            t->skips = new SkipList;
-            SkipList::const_iterator last = t->skips->before_begin();
-            for (int s = 0; s < skip_count; s++) {
-                unsigned char skip = *reinterpret_cast<unsigned char*>(dump++);
-                int32_t index = *reinterpret_cast<uint32_t*>(dump);
-                dump += sizeof(uint32_t);
-                last = t->skips->emplace_after(last, skip, trees[index]);
-            }
+// Every index of a dump within its array, and as states are created
+// after the one leading to them, edges and skips only lead to higher
+// ones - so no walk of a corrupt dump reads outside of it or loops.
+// The longest pattern and reach are what the scan windows are sized
+// by, so they are taken from the arrays and not from the header
+static bool valid_dump(const TokenTree* trees, uint32_t tree_count,
+    const SkipNode* skips, uint32_t skip_count,
+    const Edge* edges, uint32_t edge_count,
+    int64_t& longest_pattern, int64_t& longest_reach)
+{
+    // the tokens and text tokens of the longest walk from every state,
+    // children are checked before the states leading to them
+    vector<uint32_t> tokens(tree_count, 0);
+    vector<uint64_t> reach(tree_count, 0);
+    for (uint32_t t = tree_count - 1; t >= PatternTree::ROOT; --t) {
+        const TokenTree& tree = trees[t];
+        if (tree.edges > edge_count || tree.edge_count > edge_count - tree.edges)
+            return false;
+        for (uint32_t e = tree.edges; e < tree.edges + tree.edge_count; ++e) {
+            uint32_t next = edges[e].next_token;
+            if (next <= t || next >= tree_count)
+                return false;
+            // find is a binary search
+            if (e > tree.edges && edges[e - 1].element >= edges[e].element)
+                return false;
+            tokens[t] = max(tokens[t], tokens[next] + 1);
+            reach[t] = max(reach[t], reach[next] + 1);
+        }
+        // sorted by skip, so the list ends
+        int last_skip = -1;
+        for (uint32_t s = tree.skips; s; s = skips[s].next) {
+            if (s >= skip_count || skips[s].tree <= t || skips[s].tree >= tree_count
+                || skips[s].skip <= last_skip)
+                return false;
+            last_skip = skips[s].skip;
+            tokens[t] = max(tokens[t], tokens[skips[s].tree] + 1);
+            reach[t] = max(reach[t], reach[skips[s].tree] + skips[s].skip);
         }
-        t->root = *reinterpret_cast<uint32_t*>(dump);
-        dump += sizeof(uint32_t);
     }
+    longest_pattern = tokens[PatternTree::ROOT];
+    longest_reach = reach[PatternTree::ROOT];
+    return true;
+}
 
-    TokenTree::nodes.clear();
-    TokenTree::nodes.reserve(node_count);
-    m->pattern_tree->initNull();
-
-    for (unsigned int i = 1; i < node_count; i++) {
-        uint64_t element = *reinterpret_cast<uint64_t*>(dump);
-        dump += sizeof(uint64_t);
-        uint32_t left = *reinterpret_cast<uint32_t*>(dump);
-        dump += sizeof(uint32_t);
-        uint32_t right = *reinterpret_cast<uint32_t*>(dump);
-        dump += sizeof(uint32_t);
-        uint16_t level = *reinterpret_cast<uint16_t*>(dump);
-        dump += sizeof(uint16_t);
-        uint32_t nt = *reinterpret_cast<uint32_t*>(dump);
-        dump += sizeof(uint32_t);
-        TokenTree::nodes.emplace_back(element, trees[nt], left, right, level);
+bool pattern_load(Matcher* m, const char* filename)
+{
+    m->wait_compaction();
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Couldn't open %s\n", filename);
+        return false;
+    }
+    struct stat attr;
+    if (fstat(fd, &attr) == -1) {
+        fprintf(stderr, "Error accessing %s\n", filename);
+        close(fd);
+        return false;
+    }
+    size_t size = attr.st_size;
+    if (size < sizeof(DumpHeader)) {
+        fprintf(stderr, "%s is not a pattern dump\n", filename);
+        close(fd);
+        return false;
+    }
+    // shared and read only, so all processes loading it use the same pages
+    char* dump = (char*)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (dump == MAP_FAILED) {
+        fprintf(stderr, "Couldn't map %s\n", filename);
+        return false;
     }
 
-    //delete [] trees;
+    const DumpHeader* header = reinterpret_cast<const DumpHeader*>(dump);
+    if (memcmp(header->magic, DUMP_MAGIC, sizeof(DUMP_MAGIC)) || header->version != DUMP_VERSION) {
+        fprintf(stderr, "%s is not a pattern dump of version %d - recreate it\n", filename, DUMP_VERSION);
+        munmap(dump, size);
+        return false;
+    }
+    uint64_t expected = sizeof(DumpHeader)
+        + uint64_t(header->edge_count) * sizeof(Edge)
+        + uint64_t(header->tree_count) * sizeof(TokenTree)
+        + uint64_t(header->skip_count) * sizeof(SkipNode);
+    if (expected != size || header->tree_count <= PatternTree::ROOT
+        || !header->skip_count || !header->edge_count) {
+        fprintf(stderr, "%s is truncated or corrupt\n", filename);
+        munmap(dump, size);
+        return false;
+    }
 
-    m->pattern_tree->root = *reinterpret_cast<uint32_t*>(dump);
-    dump += sizeof(uint32_t);
+    const char* p = dump + sizeof(DumpHeader);
+    const Edge* edges = reinterpret_cast<const Edge*>(p);
+    p += header->edge_count * sizeof(Edge);
+    const TokenTree* trees = reinterpret_cast<const TokenTree*>(p);
+    p += header->tree_count * sizeof(TokenTree);
+    const SkipNode* skips = reinterpret_cast<const SkipNode*>(p);
+    int64_t longest_pattern, longest_reach;
+    if (!valid_dump(trees, header->tree_count, skips, header->skip_count, edges, header->edge_count,
+            longest_pattern, longest_reach)) {
+        fprintf(stderr, "%s is truncated or corrupt\n", filename);
+        munmap(dump, size);
+        return false;
+    }
 
-    munmap(dump, attr.st_size);
+    m->longest_pattern = longest_pattern;
+    m->longest_reach = longest_reach;
+    delete m->overlay;
+    m->overlay = 0;
+    m->removed.clear();
+    m->pattern_tree->use_mapping(dump, size,
+        trees, header->tree_count,
+        skips, header->skip_count,
+        edges, header->edge_count);
+    return true;
 }
 
 AV* pattern_read_lines(const char* filename, HV* needed_lines)
 {
     AV* ret = newAV();
 
-    FILE* input = fopen(filename, "r");
-    if (!input) {
-        std::cerr << "Failed to open " << filename << std::endl;
+    FileContent content;
+    if (!content.open(filename))
         return ret;
-    }
+
     // really long file :)
     char buffer[200];
-    char line[MAX_LINE_SIZE];
-    int linenumber = 1;
-    TokenList ts;
-    while (fgets(line, sizeof(line) - 1, input)) {
+    const char* line = content.data;
+    const char* end = line + content.size;
+    for (int linenumber = 1; line < end; ++linenumber) {
+        const char* nl = (const char*)memchr(line, '\n', end - line);
+        size_t len = (nl ? nl : end) - line;
         sprintf(buffer, "%d", linenumber);
         SV* val = hv_delete(needed_lines, buffer, strlen(buffer), 0);
         if (val) {
-            // fgets makes sure we have a 0 at the end
-            size_t len = strlen(line);
-            // chop
-            if (len && line[len - 1] == '\n') {
-                line[--len] = 0;
-            }
             AV* row = newAV();
             av_push(row, newSVuv(linenumber));
             // better create a new one - I'm scared of mortals
             av_push(row, newSVuv(SvUV(val)));
-            SV* str = newSVpv(line, len);
+            SV* str = newSVpvn(line, len);
             av_push(row, str);
             av_push(ret, newRV_noinc((SV*)row));
         }
         if (av_len((AV*)needed_lines) == 0)
             break;
-        ++linenumber;
+        line += len + 1;
     }
-    fclose(input);
     return ret;
 }
 
@@ -610,82 +1125,49 @@ void destroy_hash(SpookyHash* s)
     delete s;
 }
 
-static int _LevenshteinDistance(AV* s, int len_s, AV* t, int len_t)
+// the hashes of the first len entries of a normalize result
+void pattern_unpack_hashes(AV* tokens, SSize_t len, vector<uint64_t>& hashes)
 {
-    // degenerate cases
-    if (len_s == 0)
-        return len_t;
-    if (len_t == 0)
-        return len_s;
-
-    // create two work vectors of integer distances
-    int64_t* v0 = new int64_t[len_t + 1];
-    int64_t* v1 = new int64_t[len_t + 1];
-
-    // initialize v0 (the previous row of distances)
-    // this row is A[0][i]: edit distance for an empty s
-    // the distance is just the number of characters to delete from t
-    for (int i = 0; i < len_t + 1; i++)
-        v0[i] = i;
-
-    for (int i = 0; i < len_s; i++) {
-        // calculate v1 (current row distances) from the previous row v0
-
-        // first element of v1 is A[i+1][0]
-        //   edit distance is delete (i+1) chars from s to match empty t
-        v1[0] = i + 1;
-        AV* av1 = (AV*)SvRV(*av_fetch(s, i, 0));
-        SV* sv1 = *av_fetch((AV*)av1, 2, 0);
-        //fprintf(stderr, "sv %ld\n", SvUV(sv1));
-
-        // use formula to fill in the rest of the row
-        for (int j = 0; j < len_t; j++) {
-            AV* av2 = (AV*)SvRV(*av_fetch(t, j, 0));
-            SV* sv2 = *av_fetch((AV*)av2, 2, 0);
-
-            int cost = (SvUV(sv1) == SvUV(sv2)) ? 0 : 1;
-            v1[j + 1] = std::min(std::min(v1[j] + 1, v0[j + 1] + 1), v0[j] + cost);
-        }
-
-        // copy v1 (current row) to v0 (previous row) for next iteration
-        for (int j = 0; j < len_t + 1; j++)
-            v0[j] = v1[j];
+    hashes.resize(len > 0 ? len : 0);
+    for (SSize_t i = 0; i < len; ++i) {
+        SV** row = av_fetch(tokens, i, 0);
+        SV** hash = 0;
+        if (row && SvROK(*row) && SvTYPE(SvRV(*row)) == SVt_PVAV)
+            hash = av_fetch((AV*)SvRV(*row), 2, 0);
+        hashes[i] = hash ? SvUV(*hash) : 0;
     }
-
-    return v1[len_t];
 }
 
+// the last token is not compared - that's how it always was
 int pattern_distance(AV* a1, AV* a2)
 {
-    return _LevenshteinDistance(a1, av_len(a1), a2, av_len(a2));
+    vector<uint64_t> h1, h2;
+    pattern_unpack_hashes(a1, av_len(a1), h1);
+    pattern_unpack_hashes(a2, av_len(a2), h2);
+    return levenshtein_distance(h1, h2);
+}
+
+int pattern_distance_within(AV* a1, AV* a2, int k)
+{
+    vector<uint64_t> h1, h2;
+    pattern_unpack_hashes(a1, av_len(a1), h1);
+    pattern_unpack_hashes(a2, av_len(a2), h2);
+    return levenshtein_within(h1, h2, k);
 }
 
 AV* pattern_normalize(const char* p)
 {
     AV* ret = newAV();
-    Matcher* m = Matcher::self();
     TokenList t;
-    int line = 1;
-    while (true) {
-        const char* nl = strchr(p, '\n');
-        char* copy;
-        if (nl)
-            copy = strndup(p, nl - p);
-        else
-            copy = strdup(p);
-        m->tokenize(t, copy, line++);
-        free(copy);
-        if (!nl)
-            break;
-        p = nl + 1;
-    }
+    TokenTexts texts;
+    Matcher::tokenize(t, p, strlen(p), 1, &texts);
 
-    for (TokenList::const_iterator it = t.begin(); it != t.end(); ++it) {
+    for (size_t i = 0; i < t.size(); ++i) {
         AV* row = newAV();
-        av_push(row, newSVuv(it->linenumber));
-        SV* str = newSVpv(it->text.data(), it->text.length());
+        av_push(row, newSVuv(t[i].linenumber));
+        SV* str = newSVpv(texts[i].data(), texts[i].length());
         av_push(row, str);
-        av_push(row, newSVuv(it->hash));
+        av_push(row, newSVuv(t[i].hash));
         av_push(ret, newRV_noinc((SV*)row));
     }
     return ret;
@@ -20,16 +20,27 @@
 
 // map string into token array
 AV* pattern_parse(const char* str);
+int pattern_tokenizer_version();
 AV* pattern_normalize(const char* str);
+void pattern_unpack_hashes(AV* tokens, SSize_t len, std::vector<uint64_t>& hashes);
 int pattern_distance(AV* a1, AV* a2);
+int pattern_distance_within(AV* a1, AV* a2, int k);
 AV* pattern_read_lines(const char* filename, HV* needed);
 
 struct Matcher;
 Matcher* pattern_init_matcher();
+void pattern_clear(Matcher* m);
 void pattern_add(Matcher* m, unsigned id, AV* tokens);
-AV* pattern_find_matches(Matcher* m, const char* filename);
-void pattern_dump(Matcher* m, const char* filename);
-void pattern_load(Matcher* m, const char* filename);
+bool pattern_remove(Matcher* m, unsigned int id);
+AV* pattern_find_matches(Matcher* m, const char* filename, int engine);
+AV* pattern_find_matches_batch(Matcher* m, AV* filenames, int threads, int engine);
+AV* pattern_find_matches_in_string(Matcher* m, SV* text, int engine);
+AV* pattern_find_matches_in_fd(Matcher* m, int fd, int engine);
+AV* pattern_stats(Matcher* m);
+bool pattern_dump(Matcher* m, const char* filename);
+bool pattern_load(Matcher* m, const char* filename);
+void pattern_compact(Matcher* m, const char* filename);
+bool pattern_wait_compaction(Matcher* m);
 void destroy_matcher(Matcher* m);
 
 class SpookyHash;
@@ -41,7 +52,16 @@ AV* pattern_hash128(SpookyHash* s);
 class BagOfPatterns;
 BagOfPatterns* pattern_init_bag_of_patterns();
 void destroy_bag_of_patterns(BagOfPatterns *b);
-void pattern_bag_set_patterns(BagOfPatterns *b, HV *patterns);
+void pattern_bag_set_patterns(BagOfPatterns *b, HV *patterns, bool float_weights, int threads);
 AV *pattern_bag_best_for(BagOfPatterns *b, const char *str, int count);
+AV *pattern_bag_best_for_many(BagOfPatterns *b, AV *snippets, int count, int threads);
 void pattern_bag_dump(BagOfPatterns* b, const char* filename);
 bool pattern_bag_load(BagOfPatterns* b, const char* filename);
+void pattern_bag_add_pattern(BagOfPatterns* b, unsigned int id, const char* text);
+bool pattern_bag_remove_pattern(BagOfPatterns* b, unsigned int id);
+
+class NearestPatterns;
+NearestPatterns* pattern_init_nearest_patterns();
+void destroy_nearest_patterns(NearestPatterns* n);
+void pattern_nearest_add(NearestPatterns* n, unsigned int id, AV* tokens);
+AV* pattern_nearest(NearestPatterns* n, AV* tokens, int count, int threads);
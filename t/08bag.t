@@ -20,6 +20,31 @@ $result = $bag->best_for( 'GPL is great', 2 );
 is( scalar @$result, 2, 'right number' );
 is_deeply( $result->[0], { pattern => 42, match => 0.5773 }, 'fits GPL' );
 
+# the dump is checked before it's used
+open( my $fh, '<:raw', 't/08bag.dump' );
+my $dump = do { local $/; <$fh> };
+close($fh);
+my $broken = Spooky::Patterns::XS::init_bag_of_patterns;
+ok( !$broken->load('t/03match.txt'),    'refuse to load a text file' );
+ok( !$broken->load('t/does-not-exist'), 'refuse to load a missing file' );
+for my $change ( [ 'truncated', substr( $dump, 0, -4 ) ], [ 'flipped', $dump ] ) {
+    my ( $name, $content ) = @$change;
+    substr( $content, -3, 1 ) ^= "\x01" if $name eq 'flipped';
+    open( $fh, '>:raw', 't/08bag.broken' );
+    print $fh $content;
+    close($fh);
+    ok( !$bag->load('t/08bag.broken'), "refuse to load a $name dump" );
+}
+unlink('t/08bag.broken');
+is_deeply( $bag->best_for( 'GPL is great', 2 ), $result, 'still the old bag' );
+
+# the bag uses the dump in place, writing it again must not pull it away
+$bag->dump('t/08bag.dump');
+is_deeply( $bag->best_for( 'GPL is great', 2 ), $result, 'dumped over its own dump' );
+my $reloaded = Spooky::Patterns::XS::init_bag_of_patterns;
+ok( $reloaded->load('t/08bag.dump'), 'load the rewritten dump' );
+is_deeply( $reloaded->best_for( 'GPL is great', 2 ), $result, 'same bag from it' );
+
 %patterns = ();
 my $gpl = <<END_GPL;
 GNU GENERAL PUBLIC LICENSE<br>
@@ -732,6 +757,19 @@ $bag->set_patterns( \%patterns );
 $result = $bag->best_for( $gpl, 2 );
 is_deeply( $result, [ { pattern => 2, match => 0.9983 }, { pattern => 1, match => 0.0165} ], 'fits GPL better than MIT' );
 
+# only patterns sharing a word are scored, the rest fill up by ID
+%patterns = ( 7 => 'apple banana', 3 => 'apple cherry', 5 => 'date fig', 9 => 'grape' );
+$bag->set_patterns( \%patterns );
+$result = $bag->best_for( 'banana apple', 3 );
+is_deeply(
+    [ map { $_->{pattern} } @$result ],
+    [ 7, 3, 5 ],
+    'best match, shared word, then the lowest ID'
+);
+is_deeply( [ map { $_->{pattern} } @{ $bag->best_for( 'grape date fig', 4 ) } ],
+    [ 5, 9, 3, 7 ], 'all patterns' );
+is_deeply( $bag->best_for( 'apple', 0 ), [], 'none asked' );
+
 done_testing();
 
 =benchmark
@@ -0,0 +1,31 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+my $m = Spooky::Patterns::XS::init_matcher();
+
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    my $num = $1;
+    open( my $fh, '<', $fn );
+    my $str = join( '', <$fh> );
+    close($fh);
+
+    $m->add_pattern( $num, Spooky::Patterns::XS::parse_tokens($str) );
+}
+
+my @files = ( glob("t/04license.*.txt"), 't/03match.txt', 't/does-not-exist' );
+my @single = map { $m->find_matches($_) } @files;
+
+for my $threads ( 1, 2, 4, 16 ) {
+    my $batch = $m->find_matches_batch( \@files, threads => $threads );
+    cmp_deeply( $batch, \@single, "$threads threads give the same result" );
+}
+
+cmp_deeply( $m->find_matches_batch( [] ), [], "empty list" );
+
+done_testing();
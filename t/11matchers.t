@@ -0,0 +1,115 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+# no matcher needed to tokenize
+my $tokens = Spooky::Patterns::XS::parse_tokens('Hello World');
+cmp_deeply( $tokens, [ 11695443286496022098, 14227499413149678217 ],
+    "parse without matcher" );
+is( scalar @{ Spooky::Patterns::XS::normalize('Hello World') },
+    2, "normalize without matcher" );
+
+my $stable = Spooky::Patterns::XS::init_matcher();
+$stable->add_pattern( 1, $tokens );
+
+my $candidate = Spooky::Patterns::XS::init_matcher();
+$candidate->add_pattern( 2,
+    Spooky::Patterns::XS::parse_tokens('this is a $SKIP20') );
+
+cmp_deeply(
+    $stable->find_matches('t/03match.txt'),
+    [ [ 1, 1, 2 ], [ 1, 4, 4 ] ],
+    "stable matcher survives a second init_matcher"
+);
+cmp_deeply(
+    $candidate->find_matches('t/03match.txt'),
+    [ [ 2, 4, 4 ] ],
+    "candidate matcher only knows its pattern"
+);
+
+$stable->dump('t/11dump');
+undef $stable;
+
+my $loaded = Spooky::Patterns::XS::init_matcher();
+ok( $loaded->load('t/11dump'), "loaded dump" );
+cmp_deeply(
+    $loaded->find_matches('t/03match.txt'),
+    [ [ 1, 1, 2 ], [ 1, 4, 4 ] ],
+    "loaded matcher next to another one"
+);
+cmp_deeply(
+    $candidate->find_matches('t/03match.txt'),
+    [ [ 2, 4, 4 ] ],
+    "candidate matcher is not affected by load"
+);
+
+# added next to the mapped dump
+$loaded->add_pattern( 2, Spooky::Patterns::XS::parse_tokens('this is a $SKIP20') );
+cmp_deeply(
+    $loaded->find_matches('t/03match.txt'),
+    [ [ 2, 4, 4 ], [ 1, 1, 2 ], [ 1, 4, 4 ] ],
+    "extended the loaded matcher"
+);
+my $again = Spooky::Patterns::XS::init_matcher();
+ok( $again->load('t/11dump'), "loaded dump again" );
+cmp_deeply(
+    $again->find_matches('t/03match.txt'),
+    [ [ 1, 1, 2 ], [ 1, 4, 4 ] ],
+    "dump is not modified"
+);
+
+# rewriting a dump does not pull it away from who has it loaded
+$again->dump('t/11dump');
+$loaded->dump('t/11dump');
+cmp_deeply(
+    $again->find_matches('t/03match.txt'),
+    [ [ 1, 1, 2 ], [ 1, 4, 4 ] ],
+    "loaded dump survives being rewritten"
+);
+my $extended = Spooky::Patterns::XS::init_matcher();
+ok( $extended->load('t/11dump'), "loaded rewritten dump" );
+unlink('t/11dump');
+cmp_deeply(
+    $extended->find_matches('t/03match.txt'),
+    [ [ 2, 4, 4 ], [ 1, 1, 2 ], [ 1, 4, 4 ] ],
+    "rewritten dump has the added pattern"
+);
+undef $extended;
+undef $loaded;
+undef $again;
+
+my $broken = Spooky::Patterns::XS::init_matcher();
+ok( !$broken->load('t/03match.txt'), "refuse to load a text file" );
+ok( !$broken->load('t/does-not-exist'), "refuse to load a missing file" );
+
+# the first real edge of a dump leads nowhere - it's right after the
+# 40 bytes of header and the null edge, behind its 8 byte token
+$candidate->dump('t/11dump');
+open( my $fh, '+<', 't/11dump' );
+seek( $fh, 40 + 16 + 8, 0 );
+print $fh pack( 'L', 0xffffffff );
+close($fh);
+ok( !$broken->load('t/11dump'), "refuse to load a dump with a wrong index" );
+
+# the scan windows are not sized by the header - the longest reach is
+# right after the longest pattern at offset 24
+$candidate->dump('t/11dump');
+open( $fh, '+<', 't/11dump' );
+seek( $fh, 32, 0 );
+print $fh pack( 'q', 4611686018427387904 );
+close($fh);
+my $huge = Spooky::Patterns::XS::init_matcher();
+ok( $huge->load('t/11dump'), "load a dump with a wrong reach" );
+cmp_deeply(
+    $huge->find_matches('t/03match.txt'),
+    $candidate->find_matches('t/03match.txt'),
+    "reach is taken from the patterns"
+);
+unlink('t/11dump');
+cmp_deeply( $broken->find_matches('t/03match.txt'), [], "still empty" );
+
+done_testing();
@@ -0,0 +1,50 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+my $m = Spooky::Patterns::XS::init_matcher();
+
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    my $num = $1;
+    open( my $fh, '<', $fn );
+    my $str = join( '', <$fh> );
+    close($fh);
+
+    $m->add_pattern( $num, Spooky::Patterns::XS::parse_tokens($str) );
+}
+
+# patterns sharing prefixes and suffixes, so the failure links matter
+$m->add_pattern( 100, Spooky::Patterns::XS::parse_tokens('Hello World') );
+$m->add_pattern( 101,
+    Spooky::Patterns::XS::parse_tokens('world this $SKIP5 test') );
+$m->add_pattern( 102, Spooky::Patterns::XS::parse_tokens('this is a test') );
+$m->add_pattern( 103, Spooky::Patterns::XS::parse_tokens('more text here') );
+
+my @files = ( glob("t/04license.*.txt"), 't/03match.txt' );
+for my $fn (@files) {
+    my $trie = $m->find_matches($fn);
+    cmp_deeply( $m->find_matches( $fn, engine => 'aho-corasick' ),
+        $trie, "Same result for $fn" );
+}
+
+cmp_deeply(
+    $m->find_matches( 't/03match.txt', engine => 'aho-corasick' ),
+    [ [ 101, 4, 4 ], [ 103, 6, 6 ], [ 100, 1, 2 ] ],
+    "Overlapping patterns"
+);
+
+cmp_deeply(
+    $m->find_matches_batch( \@files, engine => 'aho-corasick', threads => 2 ),
+    [ map { $m->find_matches($_) } @files ],
+    "Same result in batch"
+);
+
+eval { $m->find_matches( 't/03match.txt', engine => 'grep' ) };
+like( $@, qr/Unknown engine grep/, "Unknown engine" );
+
+done_testing();
@@ -0,0 +1,59 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use File::Temp 'tempfile';
+use Spooky::Patterns::XS;
+
+my $m = Spooky::Patterns::XS::init_matcher();
+
+# nested skips over a text of the same word - every offset continues
+$m->add_pattern( 1,
+    Spooky::Patterns::XS::parse_tokens(
+        'word $SKIP20 word $SKIP20 word $SKIP20 word nomatch') );
+$m->add_pattern( 2,
+    Spooky::Patterns::XS::parse_tokens(
+        'word $SKIP20 word $SKIP20 word $SKIP20 word end') );
+$m->add_pattern( 3,
+    Spooky::Patterns::XS::parse_tokens('start $SKIP5 word $SKIP5 end') );
+
+my ( $fh, $filename ) = tempfile( UNLINK => 1 );
+print $fh "start word\n";
+for my $i ( 1 .. 300 ) {
+    print $fh $i % 10 ? 'word ' : "word\n";
+}
+print $fh "end\nword word\nword end\n";
+close $fh;
+
+cmp_deeply( $m->find_matches($filename), [ [ 2, 25, 32 ] ], "Trie" );
+my $stats = $m->stats;
+ok( $stats->{skip_pruned} > 0, "Walks were pruned" );
+# 3 skip trees entered at up to 60 offsets for each of the 305 tokens,
+# without pruning it would be 20^3 per token
+ok( $stats->{skip_walks} < 305 * 3 * 60, "Walks are bounded" );
+
+cmp_deeply( $m->find_matches( $filename, engine => 'aho-corasick' ),
+    [ [ 2, 25, 32 ] ], "Aho-Corasick" );
+ok( $m->stats->{skip_walks} > $stats->{skip_walks}, "Stats add up" );
+
+# the skip reaches further than the pattern is long - the match has to
+# be found even if it crosses the end of the first 64K of text
+$m = Spooky::Patterns::XS::init_matcher();
+$m->add_pattern( 1,
+    Spooky::Patterns::XS::parse_tokens('start $SKIP50 end') );
+my $text = "filler word\n" x 5455 . "start" . " more" x 45 . " end\n";
+cmp_deeply( $m->find_matches_in_string($text),
+    [ [ 1, 5456, 5456 ] ], "Skip over the window" );
+cmp_deeply( $m->find_matches_in_string( $text, engine => 'aho-corasick' ),
+    [ [ 1, 5456, 5456 ] ], "Skip over the window with Aho-Corasick" );
+
+my ( undef, $dump ) = tempfile( UNLINK => 1 );
+$m->dump($dump);
+$m = Spooky::Patterns::XS::init_matcher();
+$m->load($dump);
+cmp_deeply( $m->find_matches_in_string($text),
+    [ [ 1, 5456, 5456 ] ], "Reach is in the dump" );
+
+done_testing();
@@ -0,0 +1,71 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use File::Temp 'tempfile';
+use Spooky::Patterns::XS;
+
+my $m = Spooky::Patterns::XS::init_matcher();
+$m->add_pattern( 1, Spooky::Patterns::XS::parse_tokens('Hello World') );
+$m->add_pattern( 2,
+    Spooky::Patterns::XS::parse_tokens('this is the end of it') );
+
+# a minified file - one line far bigger than any buffer, with matches
+# at the 8K and 64K boundaries of line and scan buffers
+my ( $fh, $filename ) = tempfile( UNLINK => 1 );
+my $line = 'x=1;' x 1998 . 'a Hello World;';
+$line .= 'y=2;' while length($line) < 65530;
+$line .= 'Hello World' . ' z' x 40000;
+print $fh "first line\n$line\nthis is\nthe end of it";
+close $fh;
+
+cmp_deeply(
+    $m->find_matches($filename),
+    [ [ 2, 3, 4 ], [ 1, 2, 2 ], [ 1, 2, 2 ] ],
+    "Long line is not split"
+);
+cmp_deeply( $m->find_matches( $filename, engine => 'aho-corasick' ),
+    $m->find_matches($filename), "Same with Aho-Corasick" );
+
+# no whitespace anywhere near the 64K boundary, the chunk has to end
+# after another separator
+my $apache = Spooky::Patterns::XS::init_matcher();
+$apache->add_pattern( 3,
+    Spooky::Patterns::XS::parse_tokens('licensed under the apache license') );
+my $minified = 'x;' x 32766 . 'licensed;under;the;apache;license;';
+for my $text ( $minified, $minified . 'y' x 70000 ) {
+    for my $engine ( 'trie', 'aho-corasick' ) {
+        cmp_deeply( $apache->find_matches_in_string( $text, engine => $engine ),
+            [ [ 3, 1, 1 ] ], "No token split without whitespace with $engine" );
+    }
+}
+# one token longer than a chunk is taken in one piece
+cmp_deeply( $apache->find_matches_in_string( 'z' x 70000 . ';licensed under the apache license' ),
+    [ [ 3, 1, 1 ] ], "Token longer than a chunk" );
+
+my $ret = Spooky::Patterns::XS::read_lines( $filename, { 2 => 1, 4 => 2 } );
+is( length( $ret->[0][2] ), length($line), "read_lines returns long line" );
+cmp_deeply( $ret->[1], [ 4, 2, 'the end of it' ], "and the line after" );
+
+# not a regular file - it's read instead of mapped
+SKIP: {
+    skip "no /dev/fd", 1 unless -d '/dev/fd';
+    pipe( my $reader, my $writer ) or die "pipe: $!";
+    if ( !fork ) {
+        close $reader;
+        open( my $in, '<', 't/03match.txt' );
+        print {$writer} <$in>;
+        exit 0;
+    }
+    close $writer;
+    cmp_deeply(
+        $m->find_matches( '/dev/fd/' . fileno($reader) ),
+        [ [ 1, 1, 2 ], [ 1, 4, 4 ] ],
+        "Read from a pipe"
+    );
+    wait;
+}
+
+done_testing();
@@ -0,0 +1,59 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+my $m = Spooky::Patterns::XS::init_matcher();
+$m->add_pattern( 1, Spooky::Patterns::XS::parse_tokens('Hello World') );
+$m->add_pattern( 2,
+    Spooky::Patterns::XS::parse_tokens('world this $SKIP5 test') );
+
+my $expected = $m->find_matches('t/03match.txt');
+
+open( my $fh, '<', 't/03match.txt' );
+my $text = join( '', <$fh> );
+close($fh);
+
+cmp_deeply( $m->find_matches_in_string($text), $expected, "String" );
+cmp_deeply( $m->find_matches_in_string( $text, engine => 'aho-corasick' ),
+    $expected, "String with Aho-Corasick" );
+cmp_deeply( $m->find_matches_in_string(''), [], "Empty string" );
+
+# characters are matched by their UTF-8 bytes, as if read from a file
+my $unicode = "la araña\nHello World";
+utf8::decode($unicode);
+cmp_deeply( $m->find_matches_in_string($unicode),
+    [ [ 1, 2, 2 ] ], "Unicode string" );
+
+open( $fh, '<', 't/03match.txt' );
+cmp_deeply( $m->find_matches_in_fd($fh), $expected, "File handle" );
+close($fh);
+
+# from the current position on, which is line 1
+open( $fh, '<', 't/03match.txt' );
+sysseek( $fh, index( $text, "\n\n" ) + 1, 0 );
+cmp_deeply(
+    $m->find_matches_in_fd( fileno($fh) ),
+    [ map { [ $_->[0], $_->[1] - 2, $_->[2] - 2 ] }
+          grep { $_->[1] > 2 } @$expected ],
+    "File descriptor"
+);
+close($fh);
+
+pipe( my $reader, my $writer ) or die "pipe: $!";
+if ( !fork ) {
+    close $reader;
+    print {$writer} $text;
+    exit 0;
+}
+close $writer;
+cmp_deeply( $m->find_matches_in_fd($reader), $expected, "Pipe" );
+wait;
+
+eval { $m->find_matches_in_fd('nofile') };
+like( $@, qr/Not a file handle/, "Dies on other things" );
+
+done_testing();
@@ -0,0 +1,49 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+sub matcher {
+    my %patterns = @_;
+    my $m        = Spooky::Patterns::XS::init_matcher();
+    for my $id ( sort keys %patterns ) {
+        $m->add_pattern( $id,
+            Spooky::Patterns::XS::parse_tokens( $patterns{$id} ) );
+    }
+    return $m;
+}
+
+my $m = matcher(
+    5 => 'hello $SKIP1 there',
+    7 => 'hello big there',
+    9 => 'hello $SKIP2 there'
+);
+cmp_deeply( $m->find_matches_in_string("hello big there"),
+    [ [ 9, 1, 1 ] ], "Bigger ID wins on the same match" );
+
+$m = matcher(
+    3 => 'hello big there friend',
+    7 => 'hello big there',
+    9 => 'hello $SKIP1 there'
+);
+cmp_deeply( $m->find_matches_in_string("\nhello big there friend"),
+    [ [ 3, 2, 2 ] ], "Longer match wins over bigger ID" );
+
+$m = matcher( 10 => 'one two', 11 => 'two three', 12 => 'three four' );
+cmp_deeply(
+    $m->find_matches_in_string("one\ntwo\nthree\nfour"),
+    [ [ 12, 3, 4 ], [ 10, 1, 2 ] ],
+    "Overlapping matches are out"
+);
+
+$m = matcher( 20 => 'again again' );
+cmp_deeply(
+    $m->find_matches_in_string("again\nagain\nagain\nagain\nagain"),
+    [ [ 20, 1, 2 ], [ 20, 3, 4 ] ],
+    "First found wins on the same pattern"
+);
+
+done_testing();
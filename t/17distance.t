@@ -0,0 +1,66 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use List::Util 'min';
+use Spooky::Patterns::XS;
+
+# normalize returns [line, text, hash] - distance only looks at the hash
+# and not at the last token
+sub tokens {
+    return [ map { [ 1, "t$_", $_ + 1000 ] } @_, 0 ];
+}
+
+sub levenshtein {
+    my ( $s, $t ) = @_;
+    my @v0 = ( 0 .. @$t );
+    for my $i ( 0 .. $#$s ) {
+        my @v1 = ( $i + 1 );
+        for my $j ( 0 .. $#$t ) {
+            my $cost = $s->[$i] == $t->[$j] ? 0 : 1;
+            push( @v1, min( $v1[$j] + 1, $v0[ $j + 1 ] + 1, $v0[$j] + $cost ) );
+        }
+        @v0 = @v1;
+    }
+    return $v0[-1];
+}
+
+srand(42);
+my ( $ok, $within_ok ) = ( 0, 0 );
+my $cases = 300;
+for ( 1 .. $cases ) {
+    # lengths around the 64 token blocks, few symbols for many matches
+    my @a  = map { int( rand(6) ) } 1 .. int( rand(200) );
+    my @b  = @a;
+    my $ed = int( rand(40) );
+    for ( 1 .. $ed ) {
+        my $op = int( rand(3) );
+        my $i  = int( rand( @b + 1 ) );
+        if    ( $op == 0 ) { splice( @b, $i, 0, int( rand(6) ) ) }
+        elsif ( $op == 1 ) { splice( @b, $i, 1 ) }
+        else               { $b[$i] = int( rand(6) ) if $i < @b }
+    }
+    my $exp  = levenshtein( \@a, \@b );
+    my $dist = Spooky::Patterns::XS::distance( tokens(@a), tokens(@b) );
+    $ok++ if $dist == $exp;
+    # small k are done in a band, bigger ones bit parallel
+    my $agrees = 1;
+    for my $k ( 0, 1, 2, 3, 5, 10, 20, 40 ) {
+        my $within = Spooky::Patterns::XS::distance_within( tokens(@a),
+            tokens(@b), $k );
+        $agrees = 0 unless $within == ( $exp <= $k ? $exp : -1 );
+    }
+    $within_ok += $agrees;
+}
+is( $ok,        $cases, "distance is Levenshtein" );
+is( $within_ok, $cases, "distance_within agrees" );
+
+is( Spooky::Patterns::XS::distance( tokens(), tokens( 1, 2, 3 ) ), 3, "Empty" );
+is( Spooky::Patterns::XS::distance( [], [] ), 0, "Nothing at all" );
+is( Spooky::Patterns::XS::distance_within( tokens(1), tokens( 1 .. 100 ), 5 ),
+    -1, "Too different in length" );
+is( Spooky::Patterns::XS::distance_within( tokens( 1 .. 100 ), tokens( 1 .. 100 ), 0 ),
+    0, "Same" );
+
+done_testing();
@@ -0,0 +1,51 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+use File::Slurp;
+
+# the license patterns as normalized tokens, one of them slightly changed
+# as text to look for
+my %patterns;
+for my $file ( glob('t/04license.*.pattern') ) {
+    my ($id) = $file =~ m/\.(\d+)\.pattern/;
+    $patterns{$id} = Spooky::Patterns::XS::normalize( read_file($file) );
+}
+my $text = read_file('t/04license.7.pattern');
+$text =~ s/\bthe\b/a/;
+$text .= " one more line\n";
+$text = Spooky::Patterns::XS::normalize($text);
+
+my $nearest = Spooky::Patterns::XS::init_nearest_patterns();
+$nearest->add_pattern( $_, $patterns{$_} ) for sort { $a <=> $b } keys %patterns;
+
+# what a loop over distance finds
+my @expected = map { { pattern => $_, distance => Spooky::Patterns::XS::distance( $patterns{$_}, $text ) } }
+  keys %patterns;
+@expected =
+  sort { $a->{distance} <=> $b->{distance} || $a->{pattern} <=> $b->{pattern} } @expected;
+
+is( $nearest->nearest( $text, 1 )->[0]{pattern}, 7, "Changed pattern is nearest" );
+for my $threads ( 1, 4 ) {
+    for my $count ( 1, 5, 40 ) {
+        my $end = $count > @expected ? $#expected : $count - 1;
+        cmp_deeply( $nearest->nearest( $text, $count, threads => $threads ),
+            [ @expected[ 0 .. $end ] ], "Top $count on $threads threads" );
+    }
+}
+cmp_deeply( $nearest->nearest( $text, 0 ), [], "Nothing asked" );
+
+# ties are decided by the smaller ID
+my $ties = Spooky::Patterns::XS::init_nearest_patterns();
+my $same = Spooky::Patterns::XS::normalize("same text\n");
+$ties->add_pattern( $_, $same ) for ( 9, 3, 5 );
+cmp_deeply(
+    $ties->nearest( $same, 2, threads => 2 ),
+    [ { pattern => 3, distance => 0 }, { pattern => 5, distance => 0 } ],
+    "Same distance"
+);
+
+done_testing();
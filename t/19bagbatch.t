@@ -0,0 +1,47 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+my %patterns;
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    my $num = $1;
+    open( my $fh, '<', $fn );
+    $patterns{$num} = join( '', <$fh> );
+    close($fh);
+}
+
+my $bag = Spooky::Patterns::XS::init_bag_of_patterns;
+$bag->set_patterns( \%patterns );
+
+my @snippets;
+for my $fn ( glob("t/04license.*.txt") ) {
+    open( my $fh, '<', $fn );
+    push( @snippets, join( '', <$fh> ) );
+    close($fh);
+}
+push( @snippets, 'nothing in any pattern' );
+
+for my $count ( 1, 5 ) {
+    my @single = map { $bag->best_for( $_, $count ) } @snippets;
+    for my $threads ( 1, 2, 4, 16 ) {
+        my $batch = $bag->best_for_many( \@snippets, $count, threads => $threads );
+        cmp_deeply( $batch, \@single, "$threads threads give the same top $count" );
+    }
+}
+
+cmp_deeply( $bag->best_for_many( [], 1 ), [], "empty list" );
+
+for my $threads ( 2, 4, 16 ) {
+    my $threaded = Spooky::Patterns::XS::init_bag_of_patterns;
+    $threaded->set_patterns( \%patterns, threads => $threads );
+    my @results = map { $threaded->best_for( $_, 5 ) } @snippets;
+    cmp_deeply( \@results, [ map { $bag->best_for( $_, 5 ) } @snippets ],
+        "set_patterns on $threads threads gives the same bag" );
+}
+
+done_testing();
@@ -0,0 +1,55 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Spooky::Patterns::XS;
+
+my %patterns;
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    my $num = $1;
+    open( my $fh, '<', $fn );
+    $patterns{$num} = join( '', <$fh> );
+    close($fh);
+}
+
+my @snippets;
+for my $fn ( glob("t/04license.*.txt") ) {
+    open( my $fh, '<', $fn );
+    push( @snippets, join( '', <$fh> ) );
+    close($fh);
+}
+# parts of the patterns, to have more than one close one
+push( @snippets, map { substr( $_, 0, length($_) / 2 ) } values %patterns );
+
+my $double = Spooky::Patterns::XS::init_bag_of_patterns;
+$double->set_patterns( \%patterns );
+my $float = Spooky::Patterns::XS::init_bag_of_patterns;
+$float->set_patterns( \%patterns, weights => 'float' );
+$float->dump('t/20bag.dump');
+my $loaded = Spooky::Patterns::XS::init_bag_of_patterns;
+ok( $loaded->load('t/20bag.dump'), 'float dump loads' );
+unlink('t/20bag.dump');
+
+sub flat {
+    return join( ',', map { "$_->{pattern}:$_->{match}" } @{ shift() } );
+}
+
+# the matches may be off by one in the last digit, the order is the same
+my ( $same_order, $close, $same_loaded ) = ( 0, 0, 0 );
+for my $snippet (@snippets) {
+    my $exp = $double->best_for( $snippet, 5 );
+    my $got = $float->best_for( $snippet, 5 );
+    $same_order++ if join( ',', map { $_->{pattern} } @$exp ) eq join( ',', map { $_->{pattern} } @$got );
+    $close++ unless grep { abs( $exp->[$_]{match} - $got->[$_]{match} ) > 0.00011 } 0 .. $#$exp;
+    $same_loaded++ if flat( $loaded->best_for( $snippet, 5 ) ) eq flat($got);
+}
+is( $same_order,  scalar @snippets, 'same ranking' );
+is( $close,       scalar @snippets, 'same match' );
+is( $same_loaded, scalar @snippets, 'loaded the same' );
+
+eval { $float->set_patterns( \%patterns, weights => 'half' ) };
+like( $@, qr/Unknown weights half/, 'only double and float' );
+
+done_testing();
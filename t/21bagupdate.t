@@ -0,0 +1,70 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Spooky::Patterns::XS;
+
+my %patterns;
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    my $num = $1;
+    open( my $fh, '<', $fn );
+    $patterns{$num} = join( '', <$fh> );
+    close($fh);
+}
+
+my @snippets;
+for my $fn ( glob("t/04license.*.txt") ) {
+    open( my $fh, '<', $fn );
+    push( @snippets, join( '', <$fh> ) );
+    close($fh);
+}
+
+sub results {
+    my $bag = shift;
+    return join( "\n",
+        map { join( ',', map { "$_->{pattern}:$_->{match}" } @{ $bag->best_for( $_, 5 ) } ) } @snippets );
+}
+
+sub bag_of {
+    my %p   = @_;
+    my $bag = Spooky::Patterns::XS::init_bag_of_patterns;
+    $bag->set_patterns( \%p );
+    return $bag;
+}
+
+my $full = bag_of(%patterns);
+my $exp  = results($full);
+
+# every idf changes with the number of patterns, the result has to be
+# the same as with set_patterns
+my %without = %patterns;
+delete $without{7};
+my $bag = bag_of(%without);
+isnt( results($bag), $exp, 'pattern 7 makes a difference' );
+$bag->add_pattern( 7, $patterns{7} );
+is( results($bag), $exp, 'added pattern' );
+
+ok( $full->remove_pattern(7), 'removed pattern' );
+is( results($full), results( bag_of(%without) ), 'same as without' );
+ok( !$full->remove_pattern(7), 'already removed' );
+
+# replacing a pattern
+$bag->add_pattern( 7, 'GNU General Public License' );
+is( results($bag), results( bag_of( %without, 7 => 'GNU General Public License' ) ), 'replaced pattern' );
+
+# a loaded bag gets the words of its patterns back from the dump
+$bag = bag_of(%without);
+$bag->dump('t/21bag.dump');
+my $loaded = Spooky::Patterns::XS::init_bag_of_patterns;
+ok( $loaded->load('t/21bag.dump'), 'loaded' );
+unlink('t/21bag.dump');
+$loaded->add_pattern( 7, $patterns{7} );
+is( results($loaded), $exp, 'added to loaded bag' );
+
+my $empty = Spooky::Patterns::XS::init_bag_of_patterns;
+$empty->add_pattern( $_, $patterns{$_} ) for keys %patterns;
+is( results($empty), $exp, 'added one by one' );
+
+done_testing();
@@ -0,0 +1,91 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+my %patterns;
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    my $num = $1;
+    open( my $fh, '<', $fn );
+    $patterns{$num} = Spooky::Patterns::XS::parse_tokens( join( '', <$fh> ) );
+    close($fh);
+}
+my @texts = glob("t/04license.*.txt");
+
+sub matcher_for {
+    my $m = Spooky::Patterns::XS::init_matcher();
+    $m->add_pattern( $_, $patterns{$_} ) for @_;
+    return $m;
+}
+
+sub matches {
+    my ( $m, $engine ) = @_;
+    return [ map { $m->find_matches( $_, engine => $engine ) } @texts ];
+}
+
+my @ids = sort { $a <=> $b } keys %patterns;
+my @old = grep { $_ % 2 } @ids;
+my @new = grep { !( $_ % 2 ) } @ids;
+
+my $full = matcher_for(@ids);
+matcher_for(@old)->dump('t/22dump');
+
+my $m = Spooky::Patterns::XS::init_matcher();
+ok( $m->load('t/22dump'), "loaded the old patterns" );
+$m->add_pattern( $_, $patterns{$_} ) for @new;
+for my $engine ( 'trie', 'aho-corasick' ) {
+    cmp_deeply( matches( $m, $engine ), matches( $full, $engine ),
+        "patterns added to a dump match with $engine" );
+}
+
+# 1 and 3 are in the dump, 2 and 4 (which is in a lot of the texts)
+# were added to it
+my %found = map { $_->[0] => 1 } map { @$_ } @{ matches( $full, 'trie' ) };
+ok( $found{1} && $found{3} && $found{4}, "1, 3 and 4 match before" );
+ok( $m->remove_pattern(1),  "removed 1 from the dump" );
+ok( $m->remove_pattern(3),  "removed 3 from the dump" );
+ok( $m->remove_pattern(4),  "removed 4 added to the dump" );
+ok( $m->remove_pattern(2),  "removed 2 added to the dump" );
+ok( !$m->remove_pattern(1), "1 is gone already" );
+ok( !$m->remove_pattern(4), "4 is gone already" );
+ok( !$m->remove_pattern(1000), "1000 was never there" );
+my $without = matcher_for( grep { $_ > 4 } @ids );
+for my $engine ( 'trie', 'aho-corasick' ) {
+    cmp_deeply( matches( $m, $engine ), matches( $without, $engine ),
+        "removed patterns do not match with $engine" );
+}
+
+$m->compact('t/22compact');
+cmp_deeply( matches( $m, 'trie' ), matches( $without, 'trie' ),
+    "matches while compacting" );
+ok( $m->wait_compaction, "compacted" );
+my $compacted = Spooky::Patterns::XS::init_matcher();
+ok( $compacted->load('t/22compact'), "loaded the compacted dump" );
+for my $engine ( 'trie', 'aho-corasick' ) {
+    cmp_deeply( matches( $compacted, $engine ), matches( $without, $engine ),
+        "compacted dump has the same patterns with $engine" );
+}
+$without->dump('t/22dump');
+is( -s 't/22compact', -s 't/22dump', "no states of removed patterns left" );
+
+# patterns come back in the overlay - also the ones removed from the dump
+for my $matcher ( $m, $compacted ) {
+    $matcher->add_pattern( $_, $patterns{$_} ) for 1, 4;
+}
+$m->dump('t/22dump');
+my $merged = Spooky::Patterns::XS::init_matcher();
+ok( $merged->load('t/22dump'), "loaded dump with the overlay merged" );
+my $readded = matcher_for( grep { $_ != 2 && $_ != 3 } @ids );
+for my $matcher ( $m, $merged, $compacted ) {
+    for my $engine ( 'trie', 'aho-corasick' ) {
+        cmp_deeply( matches( $matcher, $engine ), matches( $readded, $engine ),
+            "readded patterns match again with $engine" );
+    }
+}
+unlink( 't/22dump', 't/22compact' );
+
+done_testing();
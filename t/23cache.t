@@ -0,0 +1,88 @@
+#! /usr/bin/perl
+
+use 5.012;
+use warnings;
+use File::Temp 'tempdir';
+use Test::More;
+use Test::Deep;
+use Spooky::Patterns::XS;
+
+my %patterns;
+for my $fn ( glob("t/04license.*.pattern") ) {
+    $fn =~ m/\.(.*)\.pattern/;
+    my $num = $1;
+    open( my $fh, '<', $fn );
+    $patterns{$num} = join( '', <$fh> );
+    close($fh);
+}
+my @texts = glob("t/04license.*.txt");
+
+sub matches {
+    my $m = shift;
+    return [ map { $m->find_matches($_) } @texts ];
+}
+
+my $built = Spooky::Patterns::XS::init_matcher();
+$built->add_pattern( $_, Spooky::Patterns::XS::parse_tokens( $patterns{$_} ) )
+  for keys %patterns;
+
+my $dir = tempdir( CLEANUP => 1 ) . "/cache";
+
+my $m = Spooky::Patterns::XS::init_matcher();
+ok( !$m->load_or_build( $dir, \%patterns ), "nothing cached yet" );
+cmp_deeply( matches($m), matches($built), "built the patterns" );
+my @dumps = glob("$dir/*");
+is( scalar @dumps, 1, "wrote one dump" );
+
+$m = Spooky::Patterns::XS::init_matcher();
+ok( $m->load_or_build( $dir, \%patterns ), "loaded the cached dump" );
+cmp_deeply( matches($m), matches($built), "same matches from the cache" );
+
+my %changed = %patterns;
+$changed{1} .= ' and then some';
+$m = Spooky::Patterns::XS::init_matcher();
+ok( !$m->load_or_build( $dir, \%changed ), "a changed pattern is compiled again" );
+is( scalar( () = glob("$dir/*") ), 2, "next to the other dump" );
+
+# a broken dump is replaced
+open( my $fh, '>', $dumps[0] );
+print $fh "garbage";
+close($fh);
+$m = Spooky::Patterns::XS::init_matcher();
+ok( !$m->load_or_build( $dir, \%patterns ), "broken dump is compiled again" );
+cmp_deeply( matches($m), matches($built), "built the patterns again" );
+$m = Spooky::Patterns::XS::init_matcher();
+ok( $m->load_or_build( $dir, \%patterns ), "and cached again" );
+
+# patterns the matcher had before are dropped, on a miss and on a hit
+my %gpl = ( 1 => $patterns{1} );
+for my $run ( 'built', 'cached' ) {
+    $m = Spooky::Patterns::XS::init_matcher();
+    $m->add_pattern( 99, Spooky::Patterns::XS::parse_tokens('licensed under') );
+    is( $m->load_or_build( $dir, \%gpl ), $run eq 'cached' ? 1 : 0, "$run over other patterns" );
+    my @ids = map { $_->[0] } map { @$_ } @{ matches($m) };
+    cmp_deeply( [ grep { $_ != 1 } @ids ], [], "only the given patterns $run" );
+    ok( scalar @ids, "and those match ($run)" );
+}
+
+# a cache that can't be written is not silent
+my @warnings;
+{
+    local $SIG{__WARN__} = sub { push( @warnings, @_ ) };
+    $m = Spooky::Patterns::XS::init_matcher();
+    ok( !$m->load_or_build( 't/23cache.t/cache', \%gpl ), "no cache" );
+}
+like( join( '', @warnings ), qr/Failed to cache the patterns/, "warns about it" );
+cmp_deeply( matches($m), matches( do { my $g = Spooky::Patterns::XS::init_matcher(); $g->load_or_build( $dir, \%gpl ); $g } ),
+    "patterns built anyway" );
+
+# the same tokens for two IDs, the higher one wins like in key order
+my %same = map { $_ => 'the very same text' } 5, 9, 12, 30, 41;
+for my $run ( 1, 2 ) {
+    $m = Spooky::Patterns::XS::init_matcher();
+    $m->load_or_build( $dir, \%same );
+    cmp_deeply( $m->find_matches_in_string('the very same text'),
+        [ [ 41, 1, 1 ] ], "duplicate patterns are added in ID order ($run)" );
+}
+
+done_testing();